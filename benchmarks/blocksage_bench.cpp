@@ -0,0 +1,531 @@
+// Microbenchmarks of the decode and meshing hot paths on fixed-seed synthetic inputs. Results
+// can be saved as JSON and compared against a saved baseline, regressions fail the run.
+//
+// Usage: blocksage-bench [--filter text] [--min-time seconds] [--json results.json]
+//                        [--compare baseline.json] [--threshold 0.1]
+
+#include "byte_buffer.h"
+#include "byte_swap.h"
+#include "nbt_parser.h"
+#include "nbt_arena.h"
+#include "chunk_decompressor.h"
+#include "region_reader.h"
+#include "section_unpacker.h"
+#include "section_mesher.h"
+#include "synthetic_region.h"
+#include "world.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+const uint64_t SEED = 42;
+const int N_REPETITIONS = 5;
+const int N_CHUNK_BLOBS = 16;
+const size_t BYTE_BUFFER_SIZE = 64 * 1024;
+const int MESHED_CHUNKS_XZ = 4;
+
+struct Benchmark
+{
+    std::string name;
+    double bytesPerOp; // 0 when throughput in bytes means nothing
+    double itemsPerOp; // Chunks, sections or blocks handled by one call of run
+    std::function<void()> run;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double bytesPerOp;
+    double itemsPerOp;
+};
+
+// Results are folded in here, so the compiler cannot drop the benchmarked work
+static volatile uint64_t sink;
+
+/*****
+ ****
+ *** Measurement
+ ****
+ ******/
+
+double timeBatch(const Benchmark &benchmark, uint64_t nIterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < nIterations; ++i)
+    {
+        benchmark.run();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+BenchmarkResult measure(const Benchmark &benchmark, double minSeconds)
+{
+    // Grow the batch until one takes a share of the minimum time, this also warms up caches
+    uint64_t nIterations = 1;
+    double seconds = timeBatch(benchmark, nIterations);
+    while (seconds < minSeconds / N_REPETITIONS)
+    {
+        nIterations = seconds > 0.0 ? std::max(nIterations * 2, static_cast<uint64_t>(nIterations * minSeconds / N_REPETITIONS / seconds)) : nIterations * 2;
+        seconds = timeBatch(benchmark, nIterations);
+    }
+
+    // Median over repetitions, robust to the odd scheduling hiccup
+    std::vector<double> nsPerOp;
+    for (int repetition = 0; repetition < N_REPETITIONS; ++repetition)
+    {
+        nsPerOp.push_back(timeBatch(benchmark, nIterations) * 1e9 / nIterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    return {benchmark.name, nIterations * N_REPETITIONS, nsPerOp[N_REPETITIONS / 2], benchmark.bytesPerOp, benchmark.itemsPerOp};
+}
+
+/*****
+ ****
+ *** Benchmarks
+ ****
+ ******/
+
+template <typename T>
+Benchmark makeByteBufferBenchmark(const std::string &name, const std::vector<char> &buffer)
+{
+    return {name, static_cast<double>(buffer.size()), static_cast<double>(buffer.size() / sizeof(T)), [&buffer]()
+            {
+                ByteBufferView view(buffer);
+                uint64_t sum = 0;
+                for (size_t i = 0; i < buffer.size() / sizeof(T); ++i)
+                {
+                    sum += view.read<T>();
+                }
+                sink = sink + sum;
+            }};
+}
+
+// Per-element read<T> against the bulk readArray on one array payload shape, checked to agree
+template <typename T>
+void addByteSwapBenchmarks(std::vector<Benchmark> &benchmarks, const std::string &shape, size_t count, std::mt19937_64 &random)
+{
+    auto payload = std::make_shared<std::vector<char>>(count * sizeof(T));
+    for (char &byte : *payload)
+    {
+        byte = static_cast<char>(random());
+    }
+    auto perElement = std::make_shared<std::vector<T>>(count);
+    auto bulk = std::make_shared<std::vector<T>>(count);
+
+    benchmarks.push_back({"byte_swap/" + shape + "/read", static_cast<double>(payload->size()), static_cast<double>(count), [payload, perElement]()
+                          {
+                              ByteBufferView view(*payload);
+                              for (T &value : *perElement)
+                              {
+                                  value = view.read<T>();
+                              }
+                              sink = sink + static_cast<uint64_t>(perElement->back());
+                          }});
+    benchmarks.push_back({"byte_swap/" + shape + "/read_array", static_cast<double>(payload->size()), static_cast<double>(count), [payload, bulk]()
+                          {
+                              ByteBufferView view(*payload);
+                              view.readArray(bulk->data(), bulk->size());
+                              sink = sink + static_cast<uint64_t>(bulk->back());
+                          }});
+
+    benchmarks[benchmarks.size() - 2].run();
+    benchmarks.back().run();
+    if (std::memcmp(perElement->data(), bulk->data(), count * sizeof(T)) != 0)
+    {
+        throw std::runtime_error("byte_swap/" + shape + ": readArray differs from read<T>");
+    }
+}
+
+// The runtime width loop the region reader used before the specialized kernels
+std::vector<uint16_t> unpackRuntime(const std::vector<uint64_t> &data, int bitLength)
+{
+    int indicesPerLong = 64 / bitLength;
+    uint64_t mask = (1ULL << bitLength) - 1;
+
+    std::vector<uint16_t> result;
+    result.reserve(TOTAL_SECTION_BLOCKS);
+    for (uint64_t value : data)
+    {
+        for (int i = 0; i < indicesPerLong && result.size() < TOTAL_SECTION_BLOCKS; ++i)
+        {
+            result.push_back((value >> (i * bitLength)) & mask);
+        }
+    }
+    return result;
+}
+
+// Cycles over the sections of the first MESHED_CHUNKS_XZ chunks on each axis
+Benchmark makeMesherBenchmark(const std::string &name, const SectionMesher &sectionMesher)
+{
+    return {name, 0.0, 1.0, [&sectionMesher, nextSection = 0]() mutable
+            {
+                int sectionIdx = nextSection++ % (MESHED_CHUNKS_XZ * MESHED_CHUNKS_XZ * N_SECTIONS_PER_CHUNK_Y);
+                int sx = sectionIdx % MESHED_CHUNKS_XZ;
+                int sz = sectionIdx / MESHED_CHUNKS_XZ % MESHED_CHUNKS_XZ;
+                int sy = sectionIdx / (MESHED_CHUNKS_XZ * MESHED_CHUNKS_XZ);
+                size_t nFaces = 0;
+                for (const auto &[blockId, faces] : sectionMesher.getSectionFaces(sx, sy, sz))
+                {
+                    nFaces += faces.size();
+                }
+                sink = sink + nFaces;
+            }};
+}
+
+std::vector<Benchmark> makeBenchmarks(const fs::path &workDirectory)
+{
+    std::vector<Benchmark> benchmarks;
+    SyntheticRegion::Options options;
+    options.seed = SEED;
+
+    // ByteBuffer reads of every width over the same random bytes
+    static std::vector<char> randomBytes(BYTE_BUFFER_SIZE);
+    std::mt19937_64 random(SEED);
+    for (char &byte : randomBytes)
+    {
+        byte = static_cast<char>(random());
+    }
+    benchmarks.push_back(makeByteBufferBenchmark<uint8_t>("byte_buffer/read_u8", randomBytes));
+    benchmarks.push_back(makeByteBufferBenchmark<uint16_t>("byte_buffer/read_u16", randomBytes));
+    benchmarks.push_back(makeByteBufferBenchmark<uint32_t>("byte_buffer/read_u32", randomBytes));
+    benchmarks.push_back(makeByteBufferBenchmark<uint64_t>("byte_buffer/read_u64", randomBytes));
+
+    // Array payloads shaped like block state data, heightmaps and the other array tags
+    addByteSwapBenchmarks<uint64_t>(benchmarks, "block_states_4bit", 256, random);
+    addByteSwapBenchmarks<uint64_t>(benchmarks, "block_states_8bit", 512, random);
+    addByteSwapBenchmarks<uint64_t>(benchmarks, "heightmap", 37, random);
+    addByteSwapBenchmarks<int32_t>(benchmarks, "int_array", 1024, random);
+    addByteSwapBenchmarks<int16_t>(benchmarks, "short_array", 4096, random);
+    addByteSwapBenchmarks<double>(benchmarks, "double_array", 1024, random);
+
+    // Chunk blobs, parsed and inflated in turn
+    static std::vector<std::vector<char>> chunkBlobs;
+    static std::vector<std::vector<char>> compressedBlobs;
+    double averageBlobSize = 0.0;
+    for (int chunkIdx = 0; chunkIdx < N_CHUNK_BLOBS; ++chunkIdx)
+    {
+        std::mt19937_64 chunkRandom(SEED + chunkIdx);
+        chunkBlobs.push_back(SyntheticRegion::makeChunkNBT(chunkIdx, 0, options, chunkRandom));
+        compressedBlobs.push_back(SyntheticRegion::compressChunk(chunkBlobs.back(), ChunkCompression::Zlib));
+        averageBlobSize += chunkBlobs.back().size() / static_cast<double>(N_CHUNK_BLOBS);
+    }
+
+    static NBTArena arena;
+    static size_t nextBlob = 0;
+    benchmarks.push_back({"nbt/parse_chunk", averageBlobSize, 1.0, []()
+                          {
+                              arena.reset();
+                              ByteBufferView view(chunkBlobs[nextBlob++ % N_CHUNK_BLOBS]);
+                              sink = sink + NBTParser::parseNBT(view, arena)->size();
+                          }});
+    benchmarks.push_back({"nbt/parse_chunk_query", averageBlobSize, 1.0, []()
+                          {
+                              arena.reset();
+                              ByteBufferView view(chunkBlobs[nextBlob++ % N_CHUNK_BLOBS]);
+                              sink = sink + NBTParser::parseNBT(view, arena, CHUNK_QUERY)->size();
+                          }});
+
+    static ZlibChunkDecompressor decompressor;
+    static std::vector<char> inflated;
+    benchmarks.push_back({"zlib/inflate_chunk", averageBlobSize, 1.0, []()
+                          {
+                              ByteBufferView view(compressedBlobs[nextBlob++ % N_CHUNK_BLOBS]);
+                              sink = sink + decompressor.decompress(view, inflated).size();
+                          }});
+
+    // Section unpacking at every width, from big-endian longs as they sit in the NBT
+    static std::vector<std::vector<char>> packedSections(MAX_SECTION_BIT_LENGTH + 1);
+    static uint16_t blockIndices[TOTAL_SECTION_BLOCKS];
+    for (int bitLength = 4; bitLength <= MAX_SECTION_BIT_LENGTH; ++bitLength)
+    {
+        int indicesPerLong = 64 / bitLength;
+        size_t nLongs = (TOTAL_SECTION_BLOCKS + indicesPerLong - 1) / indicesPerLong;
+        packedSections[bitLength].resize(nLongs * sizeof(uint64_t));
+        for (char &byte : packedSections[bitLength])
+        {
+            byte = static_cast<char>(random());
+        }
+
+        // The kernels alone on native longs, against the loop they replaced
+        auto packed = std::make_shared<std::vector<uint64_t>>(nLongs);
+        ByteBufferView(packedSections[bitLength]).readArray(packed->data(), nLongs);
+        auto unpacked = std::make_shared<std::vector<uint16_t>>(TOTAL_SECTION_BLOCKS);
+        unpackSectionIndices(packed->data(), packed->size(), bitLength, unpacked->data());
+        if (*unpacked != unpackRuntime(*packed, bitLength))
+        {
+            throw std::runtime_error("section_unpack/" + std::to_string(bitLength) + "bit: kernel differs from the runtime loop");
+        }
+        benchmarks.push_back({"section_unpack/runtime_" + std::to_string(bitLength) + "bit", static_cast<double>(nLongs * sizeof(uint64_t)), 1.0, [packed, bitLength]()
+                              {
+                                  sink = sink + unpackRuntime(*packed, bitLength).back();
+                              }});
+        benchmarks.push_back({"section_unpack/specialized_" + std::to_string(bitLength) + "bit", static_cast<double>(nLongs * sizeof(uint64_t)), 1.0, [packed, unpacked, bitLength]()
+                              {
+                                  unpackSectionIndices(packed->data(), packed->size(), bitLength, unpacked->data());
+                                  sink = sink + unpacked->back();
+                              }});
+
+        // With the big-endian copy out of the NBT payload, as chunk decoding runs it
+        benchmarks.push_back({"region_reader/process_section_" + std::to_string(bitLength) + "bit", static_cast<double>(nLongs * sizeof(uint64_t)), 1.0, [bitLength, nLongs]()
+                              {
+                                  NBTArrayView<uint64_t> data(packedSections[bitLength].data(), nLongs);
+                                  RegionReader::processSection(data, bitLength, blockIndices);
+                                  sink = sink + blockIndices[TOTAL_SECTION_BLOCKS - 1];
+                              }});
+    }
+
+    // A decoded synthetic region, walked in order and at random
+    fs::path regionPath = workDirectory / "r.0.0.mca";
+    SyntheticRegion::writeRegionFile(regionPath, 0, 0, options);
+    static std::unordered_map<std::string, uint16_t> blockIdDict = SyntheticRegion::getBlockIdDict();
+    static Region region = RegionReader::getLazyRegion(regionPath, blockIdDict);
+    for (int chunkX = 0; chunkX < N_CHUNKS_PER_REGION_XZ; ++chunkX)
+    {
+        for (int chunkZ = 0; chunkZ < N_CHUNKS_PER_REGION_XZ; ++chunkZ)
+        {
+            region.loadChunk(chunkX, chunkZ);
+        }
+    }
+
+    static std::vector<int> randomCoordinates;
+    for (int i = 0; i < TOTAL_SECTION_BLOCKS; ++i)
+    {
+        randomCoordinates.push_back(static_cast<int>(random() % (N_CHUNKS_PER_REGION_XZ * SECTION_SIZE)));
+        randomCoordinates.push_back(static_cast<int>(random() % CHUNK_SIZE_Y));
+        randomCoordinates.push_back(static_cast<int>(random() % (N_CHUNKS_PER_REGION_XZ * SECTION_SIZE)));
+    }
+    static int nextSection = 0;
+    benchmarks.push_back({"region/get_block_at_sequential", 0.0, TOTAL_SECTION_BLOCKS, []()
+                          {
+                              // One section after the other, in YZX order within each
+                              int sectionIdx = nextSection++ % (N_CHUNKS_PER_REGION_XZ * N_SECTIONS_PER_CHUNK_Y);
+                              int baseX = (sectionIdx % N_CHUNKS_PER_REGION_XZ) * SECTION_SIZE;
+                              int baseY = (sectionIdx / N_CHUNKS_PER_REGION_XZ) * SECTION_SIZE;
+                              uint64_t sum = 0;
+                              for (int y = 0; y < SECTION_SIZE; ++y)
+                              {
+                                  for (int z = 0; z < SECTION_SIZE; ++z)
+                                  {
+                                      for (int x = 0; x < SECTION_SIZE; ++x)
+                                      {
+                                          sum += region.getBlockAt(baseX + x, baseY + y, z);
+                                      }
+                                  }
+                              }
+                              sink = sink + sum;
+                          }});
+    benchmarks.push_back({"region/get_block_at_random", 0.0, TOTAL_SECTION_BLOCKS, []()
+                          {
+                              uint64_t sum = 0;
+                              for (size_t i = 0; i < randomCoordinates.size(); i += 3)
+                              {
+                                  sum += region.getBlockAt(randomCoordinates[i], randomCoordinates[i + 1], randomCoordinates[i + 2]);
+                              }
+                              sink = sink + sum;
+                          }});
+
+    // Face extraction over the sections of a few chunks, with their neighbours decoded. The
+    // checkerboard is the worst case, every solid block shows all its faces.
+    SyntheticRegion::Options checkerboardOptions = options;
+    checkerboardOptions.pattern = SyntheticRegion::Pattern::Checkerboard;
+    checkerboardOptions.uniformSectionShare = 0.0;
+    fs::create_directories(workDirectory / "checkerboard");
+    SyntheticRegion::writeRegionFile(workDirectory / "checkerboard" / "r.0.0.mca", 0, 0, checkerboardOptions);
+
+    static World world(workDirectory, blockIdDict);
+    static World checkerboardWorld(workDirectory / "checkerboard", blockIdDict);
+    static SectionMesher sectionMesher(world, {0});
+    static SectionMesher checkerboardSectionMesher(checkerboardWorld, {0});
+    for (int chunkX = 0; chunkX <= MESHED_CHUNKS_XZ; ++chunkX)
+    {
+        for (int chunkZ = 0; chunkZ <= MESHED_CHUNKS_XZ; ++chunkZ)
+        {
+            world.loadChunk(chunkX, chunkZ);
+            checkerboardWorld.loadChunk(chunkX, chunkZ);
+        }
+    }
+    benchmarks.push_back(makeMesherBenchmark("mesher/section_faces", sectionMesher));
+    benchmarks.push_back(makeMesherBenchmark("mesher/section_faces_checkerboard", checkerboardSectionMesher));
+
+    return benchmarks;
+}
+
+/*****
+ ****
+ *** Reporting
+ ****
+ ******/
+
+json toJson(const std::vector<BenchmarkResult> &results)
+{
+    json benchmarks = json::array();
+    for (const BenchmarkResult &result : results)
+    {
+        benchmarks.push_back({{"name", result.name},
+                              {"iterations", result.iterations},
+                              {"nsPerOp", result.nsPerOp},
+                              {"mbPerSecond", result.bytesPerOp / result.nsPerOp * 1e3},
+                              {"itemsPerSecond", result.itemsPerOp / result.nsPerOp * 1e9}});
+    }
+    return {{"seed", SEED}, {"byteSwapKernel", getByteSwapKernelName()}, {"unpackKernel", getSectionUnpackKernelName()}, {"benchmarks", benchmarks}};
+}
+
+// Rate with a k, M or G prefix, so chunk and block rates share one column
+std::string formatRate(double perSecond, const std::string &unit)
+{
+    const char *prefixes[] = {"", "k", "M", "G"};
+    int prefixIdx = 0;
+    while (perSecond >= 1000.0 && prefixIdx < 3)
+    {
+        perSecond /= 1000.0;
+        prefixIdx++;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << perSecond << " " << prefixes[prefixIdx] << unit;
+    return out.str();
+}
+
+void printResult(const BenchmarkResult &result)
+{
+    std::cout << std::left << std::setw(40) << result.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.nsPerOp << " ns/op"
+              << std::setw(16) << (result.bytesPerOp > 0.0 ? formatRate(result.bytesPerOp / result.nsPerOp * 1e9, "B/s") : "")
+              << std::setw(18) << formatRate(result.itemsPerOp / result.nsPerOp * 1e9, "items/s") << std::endl;
+}
+
+// Returns the number of benchmarks slower than the baseline by more than threshold
+int compareWithBaseline(const std::vector<BenchmarkResult> &results, const fs::path &baselinePath, double threshold)
+{
+    std::ifstream file(baselinePath);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open baseline " + baselinePath.string());
+    }
+    json baseline = json::parse(file);
+    std::unordered_map<std::string, double> baselineNsPerOp;
+    for (const json &benchmark : baseline["benchmarks"])
+    {
+        baselineNsPerOp[benchmark["name"].get<std::string>()] = benchmark["nsPerOp"].get<double>();
+    }
+
+    std::cout << std::endl
+              << "Compared with " << baselinePath.string() << ", regressions are over " << threshold * 100 << "%" << std::endl;
+    int nRegressions = 0;
+    for (const BenchmarkResult &result : results)
+    {
+        std::cout << std::left << std::setw(40) << result.name << std::right;
+        auto it = baselineNsPerOp.find(result.name);
+        if (it == baselineNsPerOp.end())
+        {
+            std::cout << "  not in baseline" << std::endl;
+            continue;
+        }
+
+        double change = result.nsPerOp / it->second - 1.0;
+        bool regression = change > threshold;
+        nRegressions += regression ? 1 : 0;
+        std::cout << std::fixed << std::setprecision(1) << std::setw(14) << it->second << " -> " << std::setw(12) << result.nsPerOp << " ns/op"
+                  << std::showpos << std::setw(10) << change * 100 << "%" << std::noshowpos << (regression ? "  REGRESSION" : "") << std::endl;
+    }
+    return nRegressions;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    double minSeconds = 0.5;
+    double threshold = 0.1;
+    fs::path jsonPath;
+    fs::path baselinePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (argument == "--min-time" && i + 1 < argc)
+        {
+            minSeconds = std::atof(argv[++i]);
+        }
+        else if (argument == "--json" && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (argument == "--compare" && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (argument == "--threshold" && i + 1 < argc)
+        {
+            threshold = std::atof(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter text] [--min-time seconds] [--json results.json] [--compare baseline.json] [--threshold 0.1]" << std::endl;
+            return 1;
+        }
+    }
+
+    fs::path workDirectory = fs::temp_directory_path() / ("blocksage-bench-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    int exitCode = 0;
+    try
+    {
+        fs::create_directories(workDirectory);
+        std::vector<Benchmark> benchmarks = makeBenchmarks(workDirectory);
+
+        std::cout << "Byte swap kernel: " << getByteSwapKernelName() << std::endl;
+        std::cout << "Section unpack kernel: " << getSectionUnpackKernelName() << std::endl;
+        std::vector<BenchmarkResult> results;
+        for (const Benchmark &benchmark : benchmarks)
+        {
+            if (benchmark.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            results.push_back(measure(benchmark, minSeconds));
+            printResult(results.back());
+        }
+
+        if (!jsonPath.empty())
+        {
+            std::ofstream file(jsonPath);
+            file << toJson(results).dump(2) << std::endl;
+            if (!file)
+            {
+                throw std::runtime_error("Failed to write " + jsonPath.string());
+            }
+        }
+        if (!baselinePath.empty() && compareWithBaseline(results, baselinePath, threshold) > 0)
+        {
+            exitCode = 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exitCode = 1;
+    }
+
+    std::error_code error;
+    fs::remove_all(workDirectory, error);
+    return exitCode;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "perfect_hash.h"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <ostream>
+#include <cstdint>
+
+// Maps block names to IDs. Names missing from the dictionary resolve to a fallback ID and
+// are tallied, so they can be reported once per region instead of once per block. The
+// dictionary is copied into a perfect hash table, so a resolver can outlive it when regions
+// decode chunks lazily and known names resolve without allocating.
+class BlockIdResolver
+{
+public:
+    BlockIdResolver(const std::unordered_map<std::string, uint16_t> &blockIdDict, uint16_t fallbackId = 0xFFFF, size_t maxReportedNames = 10);
+
+    // Resolves with a compiled table such as BlockTable, looked up in place instead of copied.
+    // Templated because the core library is built before the table is generated, only the
+    // targets including it see its contents.
+    template <typename Table>
+    explicit BlockIdResolver(Table, uint16_t fallbackId = 0xFFFF, size_t maxReportedNames = 10)
+        : findTableBlockId(&findBlockId<Table>), fallbackId(fallbackId), maxReportedNames(maxReportedNames)
+    {
+        std::vector<std::pair<std::string_view, uint16_t>> tableEntries;
+        tableEntries.reserve(Table::getBlockCount());
+        for (size_t blockIdx = 0; blockIdx < Table::getBlockCount(); ++blockIdx)
+        {
+            tableEntries.emplace_back(Table::getBlock(blockIdx).name, Table::getBlock(blockIdx).id);
+        }
+        dictionaryHash = hashDictionary(std::move(tableEntries), fallbackId);
+    }
+
+    // Safe to call from several workers at once
+    uint16_t resolve(std::string_view blockName);
+
+    // Print the unknown names seen since the last report, most frequent first, and forget them
+    void reportUnknownBlocks(std::ostream &out);
+
+    uint16_t getFallbackId() const;
+
+    // Hash of the dictionary and fallback ID, identifies the block IDs a resolver produces
+    uint64_t getDictionaryHash() const;
+
+private:
+    // ID of a name in a compiled table, -1 for names outside it
+    template <typename Table>
+    static int32_t findBlockId(std::string_view blockName)
+    {
+        const auto *block = Table::find(blockName);
+        return block ? static_cast<int32_t>(block->id) : -1;
+    }
+
+    // Same hash for the same names and IDs, whether they come from a dictionary or a table
+    static uint64_t hashDictionary(std::vector<std::pair<std::string_view, uint16_t>> entries, uint16_t fallbackId);
+
+    int32_t (*findTableBlockId)(std::string_view blockName); // Null when resolving with the entries below
+    std::vector<std::pair<std::string, uint16_t>> entries; // Sorted by name
+    PerfectHash::Table table;
+    uint16_t fallbackId;
+    size_t maxReportedNames;
+    uint64_t dictionaryHash;
+
+    std::mutex unknownMutex;
+    std::unordered_map<std::string, size_t> unknownCounts;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "perfect_hash.h"
+#include "config.h"
+#include <string_view>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+enum BlockFlags : uint8_t
+{
+    BLOCK_HAS_COLOR = 1 << 0,
+    BLOCK_NO_RENDER = 1 << 1,
+};
+
+struct BlockInfo
+{
+    std::string_view name; // Without the minecraft: namespace
+    BlockId id;
+    float color[3];
+    uint8_t flags;
+};
+
+// Generated from the block dictionaries by tools/generate_block_table.cpp. Without it the
+// table is empty and the viewer reads the JSON dictionaries at startup.
+#if __has_include("generated/block_table_data.h")
+#include "generated/block_table_data.h"
+#else
+inline constexpr size_t BLOCK_TABLE_COUNT = 0;
+inline constexpr BlockInfo BLOCK_TABLE_BLOCKS[] = {{"", 0xFFFF, {0.0f, 0.0f, 0.0f}, 0}};
+inline constexpr uint32_t BLOCK_TABLE_SEEDS[] = {0};
+inline constexpr int32_t BLOCK_TABLE_SLOTS[] = {-1};
+#endif
+
+// Block names, IDs, colors and flags compiled into the binary as a perfect hash table
+class BlockTable
+{
+public:
+    static constexpr size_t getBlockCount()
+    {
+        return BLOCK_TABLE_COUNT;
+    }
+
+    static constexpr const BlockInfo &getBlock(size_t blockIdx)
+    {
+        return BLOCK_TABLE_BLOCKS[blockIdx];
+    }
+
+    // Returns nullptr for names outside the table
+    static constexpr const BlockInfo *find(std::string_view name)
+    {
+        if (BLOCK_TABLE_COUNT == 0)
+        {
+            return nullptr;
+        }
+
+        int32_t blockIdx = BLOCK_TABLE_SLOTS[findPerfectHashSlot(name, BLOCK_TABLE_SEEDS, std::size(BLOCK_TABLE_SEEDS), std::size(BLOCK_TABLE_SLOTS))];
+        return blockIdx >= 0 && BLOCK_TABLE_BLOCKS[blockIdx].name == name ? &BLOCK_TABLE_BLOCKS[blockIdx] : nullptr;
+    }
+};
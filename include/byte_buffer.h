@@ -2,39 +2,62 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdint>
 #include <type_traits>
 #include <stdexcept>
+#include "byte_swap.h"
 
-class ByteBuffer
+// Non-owning big-endian reader over a byte range. The viewed memory must outlive the view.
+class ByteBufferView
 {
 public:
-    ByteBuffer(const std::vector<char>& data) : data_(data), position_(0) {}
-    ByteBuffer(std::vector<char>&& data) : data_(std::move(data)), position_(0) {}
+    ByteBufferView() : data_(nullptr), size_(0), position_(0) {}
+    ByteBufferView(const char *data, size_t size) : data_(data), size_(size), position_(0) {}
+    ByteBufferView(std::string_view data) : data_(data.data()), size_(data.size()), position_(0) {}
+    ByteBufferView(const std::vector<char> &data) : data_(data.data()), size_(data.size()), position_(0) {}
 
-    void seek(size_t position) { 
-        if (position > data_.size()) {
+    void seek(size_t position) {
+        if (position > size_) {
             throw std::out_of_range("Seek position out of bounds");
         }
-        position_ = position; 
+        position_ = position;
+    }
+
+    void skip(size_t size) {
+        if (size > size_ - position_) {
+            throw std::out_of_range("Skip beyond buffer bounds");
+        }
+        position_ += size;
     }
 
     template <typename T>
     T read()
     {
-        if (position_ + sizeof(T) > data_.size()) {
+        // Floating point values are stored as big-endian IEEE 754 bit patterns
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+            Bits bits = read<Bits>();
+            T value;
+            std::memcpy(&value, &bits, sizeof(T));
+            return value;
+        }
+
+        if (position_ + sizeof(T) > size_) {
             throw std::out_of_range("Read beyond buffer bounds");
         }
 
         T value;
-        std::memcpy(&value, data_.data() + position_, sizeof(T));
+        std::memcpy(&value, data_ + position_, sizeof(T));
         position_ += sizeof(T);
 
         // Convert from big-endian to host endian if needed
         if constexpr (sizeof(T) > 1 && std::is_integral_v<T>)
         {
             if constexpr (sizeof(T) == 2) { // 16-bit
-                value = ((value & 0xFF00) >> 8) | 
+                value = ((value & 0xFF00) >> 8) |
                         ((value & 0x00FF) << 8);
             }
             else if constexpr (sizeof(T) == 4) { // 32-bit
@@ -60,63 +83,125 @@ public:
 
     std::vector<char> read(size_t size)
     {
-        if (position_ + size > data_.size()) {
+        ByteBufferView view = readView(size);
+        return std::vector<char>(view.bytes(), view.bytes() + view.size());
+    }
+
+    ByteBufferView readView(size_t size)
+    {
+        if (position_ + size > size_) {
             throw std::out_of_range("Read beyond buffer bounds");
         }
 
-        std::vector<char> result(size);
-        std::memcpy(result.data(), data_.data() + position_, size);
+        ByteBufferView result(data_ + position_, size);
         position_ += size;
         return result;
     }
 
     std::string readString(size_t length)
     {
-        if (position_ + length > data_.size()) {
+        return std::string(readStringView(length));
+    }
+
+    std::string_view readStringView(size_t length)
+    {
+        if (position_ + length > size_) {
             throw std::out_of_range("Read beyond buffer bounds");
         }
 
-        std::string result(data_.data() + position_, length);
+        std::string_view result(data_ + position_, length);
         position_ += length;
         return result;
     }
 
+    // Bulk read of big-endian elements: one bounds check, then a vectorized byte swap
     template <typename T>
-    std::vector<T> readVector(size_t length)
+    void readArray(T *destination, size_t length)
     {
-        std::vector<T> result;
-        result.reserve(length);
-        for (size_t i = 0; i < length; ++i) {
-            result.push_back(read<T>());
+        static_assert(std::is_arithmetic_v<T>, "readArray needs an arithmetic element type");
+        if (length > (size_ - position_) / sizeof(T)) {
+            throw std::out_of_range("Read beyond buffer bounds");
         }
+
+        readBigEndianArray(data_ + position_, destination, length);
+        position_ += length * sizeof(T);
+    }
+
+    template <typename T>
+    std::vector<T> readVector(size_t length)
+    {
+        std::vector<T> result(length);
+        readArray(result.data(), length);
         return result;
     }
 
     std::vector<int8_t> readByteArray(size_t length)
     {
-        if (position_ + length > data_.size()) {
+        if (position_ + length > size_) {
             throw std::out_of_range("Read beyond buffer bounds");
         }
 
         std::vector<int8_t> result(length);
-        std::memcpy(result.data(), data_.data() + position_, length);
+        std::memcpy(result.data(), data_ + position_, length);
         position_ += length;
         return result;
     }
 
     size_t remaining() const {
-        return data_.size() - position_;
+        return size_ - position_;
     }
 
     size_t position() const {
         return position_;
     }
 
-    const std::vector<char>& data() const { 
-        return data_; 
+    size_t size() const {
+        return size_;
+    }
+
+    const char *bytes() const {
+        return data_;
+    }
+
+protected:
+    void rebind(const char *data, size_t size, size_t position) {
+        data_ = data;
+        size_ = size;
+        position_ = position;
     }
 
 private:
-    std::vector<char> data_;
+    const char *data_;
+    size_t size_;
     size_t position_;
-};
\ No newline at end of file
+};
+
+// Owning buffer, for data that has no other home such as a decompressed chunk.
+class ByteBuffer : public ByteBufferView
+{
+public:
+    ByteBuffer(const std::vector<char>& data) : data_(data) { rebind(data_.data(), data_.size(), 0); }
+    ByteBuffer(std::vector<char>&& data) : data_(std::move(data)) { rebind(data_.data(), data_.size(), 0); }
+    ByteBuffer(const ByteBuffer &other) : ByteBufferView(other), data_(other.data_) { rebind(data_.data(), data_.size(), other.position()); }
+    ByteBuffer(ByteBuffer &&other) noexcept : ByteBufferView(other), data_(std::move(other.data_)) { rebind(data_.data(), data_.size(), other.position()); }
+
+    ByteBuffer &operator=(const ByteBuffer &other) {
+        data_ = other.data_;
+        rebind(data_.data(), data_.size(), other.position());
+        return *this;
+    }
+
+    ByteBuffer &operator=(ByteBuffer &&other) noexcept {
+        size_t position = other.position();
+        data_ = std::move(other.data_);
+        rebind(data_.data(), data_.size(), position);
+        return *this;
+    }
+
+    const std::vector<char>& data() const {
+        return data_;
+    }
+
+private:
+    std::vector<char> data_;
+};
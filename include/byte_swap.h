@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Bulk big-endian to host conversion for NBT array payloads. The best kernel for the
+// running CPU (AVX2, SSSE3 or scalar) is picked once on first use.
+void byteSwap16(const char *source, uint16_t *destination, size_t count);
+void byteSwap32(const char *source, uint32_t *destination, size_t count);
+void byteSwap64(const char *source, uint64_t *destination, size_t count);
+
+// Name of the kernel in use, for benchmarks and diagnostics
+const char *getByteSwapKernelName();
+
+template <typename T>
+void readBigEndianArray(const char *source, T *destination, size_t count)
+{
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "Unsupported element size");
+
+    if constexpr (sizeof(T) == 1)
+    {
+        std::memcpy(destination, source, count);
+    }
+    else if constexpr (sizeof(T) == 2)
+    {
+        byteSwap16(source, reinterpret_cast<uint16_t *>(destination), count);
+    }
+    else if constexpr (sizeof(T) == 4)
+    {
+        byteSwap32(source, reinterpret_cast<uint32_t *>(destination), count);
+    }
+    else
+    {
+        byteSwap64(source, reinterpret_cast<uint64_t *>(destination), count);
+    }
+}
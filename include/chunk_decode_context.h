@@ -0,0 +1,85 @@
+#pragma once
+
+#include "chunk_decompressor.h"
+#include "nbt_arena.h"
+#include "nbt_parser.h"
+#include "byte_buffer.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// Steps of decoding a chunk, timed when stage timing is enabled
+enum class DecodeStage
+{
+    Read,    // Chunk header and compressed bytes, page faults of the mapping land here
+    Inflate, // Decompression, bytes are the decompressed size
+    Parse,   // NBT parsing of the decompressed bytes
+    Palette, // Palette names resolved to block IDs, bytes are the name lengths
+    Unpack,  // Packed indices expanded, bytes are the packed longs
+    Store    // Sections repacked into SectionData, bytes are the expanded indices
+};
+const size_t N_DECODE_STAGES = static_cast<size_t>(DecodeStage::Store) + 1;
+
+// Setup and allocation counters, summed over every decode context
+struct ChunkDecodeStats
+{
+    uint64_t chunks = 0;
+    uint64_t decompressorSetups = 0;
+    uint64_t bufferGrowths = 0;
+    uint64_t arenaBlockAllocations = 0;
+
+    // Summed over the workers, so stage times add up to more than the wall time
+    std::array<uint64_t, N_DECODE_STAGES> stageNanoseconds = {};
+    std::array<uint64_t, N_DECODE_STAGES> stageBytes = {};
+};
+
+// Stage totals of one decode context, written by its worker only and read by getTotalStats()
+struct DecodeStageCounters
+{
+    std::array<std::atomic<uint64_t>, N_DECODE_STAGES> nanoseconds = {};
+    std::array<std::atomic<uint64_t>, N_DECODE_STAGES> bytes = {};
+};
+
+// Per-worker state reused across the chunks it decodes: one decompressor per compression
+// type, a grow-only output buffer and the NBT arena. After the first few chunks a worker
+// decodes without allocating.
+class ChunkDecodeContext
+{
+public:
+    ChunkDecodeContext();
+
+    ChunkDecodeContext(const ChunkDecodeContext &) = delete;
+    ChunkDecodeContext &operator=(const ChunkDecodeContext &) = delete;
+
+    static ChunkDecodeContext &forCurrentThread();
+
+    // Start a new chunk, the previous chunk's decompressed bytes and NBT tree are released
+    void beginChunk();
+
+    ByteBufferView decompress(uint8_t compressionType, const ByteBufferView &input);
+
+    // Parse the decompressed chunk into this context's arena
+    const NBTParser::NBTNode *parse(ByteBufferView &nbt, const NBTParser::NBTPathQuery &query);
+
+    // Stage timing costs a clock read per stage and section, it is off unless a tool enables it
+    static void setStageTiming(bool enabled);
+    static bool isStageTiming();
+
+    // Start of a stage, pass it to endStage() once the stage is done
+    std::chrono::steady_clock::time_point beginStage() const;
+    void endStage(DecodeStage stage, std::chrono::steady_clock::time_point start, uint64_t bytes);
+
+    static ChunkDecodeStats getTotalStats();
+
+private:
+    std::array<std::unique_ptr<ChunkDecompressor>, static_cast<size_t>(ChunkCompression::LZ4) + 1> decompressors;
+    std::vector<char> output;
+    NBTArena arena;
+    std::shared_ptr<DecodeStageCounters> stageCounters;
+    bool stageTiming;
+
+    ChunkDecompressor &getDecompressor(uint8_t compressionType);
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "byte_buffer.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+struct z_stream_s;
+
+// Compression type byte stored in front of every chunk in a region file
+enum class ChunkCompression : uint8_t
+{
+    Gzip = 1,
+    Zlib = 2,
+    Uncompressed = 3,
+    LZ4 = 4,
+    Custom = 127
+};
+
+// Largest decompressed chunk accepted, so a corrupt size field cannot force a huge buffer
+const size_t MAX_CHUNK_BYTES = 64 * 1024 * 1024;
+
+// Flag set on the compression type when the chunk is stored in an external .mcc file
+const uint8_t EXTERNAL_CHUNK_FLAG = 0x80;
+
+// Turns a chunk payload into its NBT bytes in a single pass. Output is written into a
+// caller-owned buffer which is only ever grown, the returned view covers the decompressed bytes.
+class ChunkDecompressor
+{
+public:
+    virtual ~ChunkDecompressor() = default;
+
+    virtual ByteBufferView decompress(const ByteBufferView &input, std::vector<char> &output) = 0;
+
+    static std::unique_ptr<ChunkDecompressor> create(uint8_t compressionType);
+};
+
+// The z_stream is set up on first use and reset, not reinitialized, for every following chunk
+class ZlibChunkDecompressor : public ChunkDecompressor
+{
+public:
+    ZlibChunkDecompressor();
+    ~ZlibChunkDecompressor() override;
+
+    ZlibChunkDecompressor(const ZlibChunkDecompressor &) = delete;
+    ZlibChunkDecompressor &operator=(const ZlibChunkDecompressor &) = delete;
+
+    ByteBufferView decompress(const ByteBufferView &input, std::vector<char> &output) override;
+
+protected:
+    ByteBufferView inflateSingleShot(const ByteBufferView &input, std::vector<char> &output, int windowBits, size_t expectedSize);
+
+private:
+    std::unique_ptr<z_stream_s> stream;
+    int streamWindowBits;
+
+    void prepareStream(int windowBits);
+};
+
+class GzipChunkDecompressor : public ZlibChunkDecompressor
+{
+public:
+    ByteBufferView decompress(const ByteBufferView &input, std::vector<char> &output) override;
+};
+
+class UncompressedChunkDecompressor : public ChunkDecompressor
+{
+public:
+    ByteBufferView decompress(const ByteBufferView &input, std::vector<char> &output) override;
+};
+
+// LZ4 as written by Minecraft servers: lz4-java's LZ4BlockOutputStream framing around LZ4 blocks
+class LZ4ChunkDecompressor : public ChunkDecompressor
+{
+public:
+    ByteBufferView decompress(const ByteBufferView &input, std::vector<char> &output) override;
+
+    static size_t decompressBlock(const char *input, size_t inputSize, char *output, size_t outputSize);
+};
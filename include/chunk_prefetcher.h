@@ -0,0 +1,39 @@
+#pragma once
+
+#include "world.h"
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+// Decodes chunks ahead of a moving camera. The camera trajectory is extrapolated from its
+// velocity and the chunks that will come within view distance are queued in order of arrival,
+// on a few tasks of the shared thread pool. Each update replaces the queue, so chunks the new
+// trajectory no longer reaches are dropped before they start decoding.
+class ChunkPrefetcher
+{
+public:
+    ChunkPrefetcher(World &world, float lookaheadSeconds = 2.0f, size_t maxWorkers = 2);
+    ~ChunkPrefetcher();
+
+    ChunkPrefetcher(const ChunkPrefetcher &) = delete;
+    ChunkPrefetcher &operator=(const ChunkPrefetcher &) = delete;
+
+    // Position and velocity are in blocks and blocks per second, radius is the view distance in blocks
+    void update(float x, float z, float velocityX, float velocityZ, int radius);
+
+    size_t getPendingCount();
+
+private:
+    void workerFunction();
+
+    World &world;
+    float lookaheadSeconds;
+    size_t maxWorkers;
+
+    std::mutex pendingMutex;
+    std::condition_variable workersCondition;
+    std::deque<std::pair<int, int>> pendingChunks; // Global chunk coordinates, soonest first
+    size_t nActiveWorkers;
+};
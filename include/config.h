@@ -1,18 +1,21 @@
 #pragma once
 
-#include <vector>
+#include <cstdint>
 
 using BlockId = uint16_t;
-using SectionLineData = std::vector<BlockId>;          // Z dimension within a section
-using SectionPlaneData = std::vector<SectionLineData>; // Y dimension within a section
-using SectionData = std::vector<SectionPlaneData>;     // X dimension within a section
-using ChunkData = std::vector<SectionData>;            // Sections in a chunk
-using ChunkLineData = std::vector<ChunkData>;          // Chunk in region
-using RegionData = std::vector<ChunkLineData>;         // Final 3D region
 
 const int N_CHUNKS_PER_REGION_XZ = 32;
+const int REGION_SHIFT = 5; // log2(N_CHUNKS_PER_REGION_XZ)
+const int REGION_MASK = N_CHUNKS_PER_REGION_XZ - 1;
 const int CHUNK_SIZE_Y = 384;
 const int SECTION_SIZE = 16;
+const int SECTION_SHIFT = 4; // log2(SECTION_SIZE)
+const int SECTION_MASK = SECTION_SIZE - 1;
 const int N_SECTIONS_PER_CHUNK_Y = CHUNK_SIZE_Y / SECTION_SIZE;
+const int TOTAL_SECTION_BLOCKS = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
 const int MIN_Y = -64;
-const int MAX_Y = 320;
\ No newline at end of file
+const int MAX_Y = 320;
+
+const int SECTOR_BYTES = 4096;
+const int OFFSET_SHIFT = 8;
+const int SECTOR_COUNT_MASK = 0xFF;
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+// Runtime CPU feature detection for the SIMD kernels. Kernels are compiled for their
+// instruction set per function, so the default build runs on any x86-64 CPU.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+// MSVC accepts any intrinsic in any function, GCC and Clang need the target per function
+#if defined(SIMD_X86) && !defined(_MSC_VER)
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+bool cpuHasSSSE3();
+bool cpuHasAVX2();
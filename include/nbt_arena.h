@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+// Bump allocator for per-chunk NBT trees. Nothing is freed individually: reset() releases
+// every allocation at once and keeps the blocks for the next chunk parsed on the same worker.
+class NBTArena
+{
+public:
+    explicit NBTArena(size_t blockSize = 64 * 1024) : blockSize(blockSize), currentBlock(0), currentOffset(0), blockAllocations(0) {}
+
+    NBTArena(const NBTArena &) = delete;
+    NBTArena &operator=(const NBTArena &) = delete;
+
+    template <typename T>
+    T *allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+        return static_cast<T *>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    void reset()
+    {
+        currentBlock = 0;
+        currentOffset = 0;
+    }
+
+    size_t getCapacity() const
+    {
+        size_t capacity = 0;
+        for (const Block &block : blocks)
+        {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+    size_t getBlockAllocations() const
+    {
+        return blockAllocations;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t currentBlock;
+    size_t currentOffset;
+    size_t blockAllocations;
+
+    void *allocateBytes(size_t size, size_t alignment)
+    {
+        // Find the first block, from the current one on, with enough room
+        while (currentBlock < blocks.size())
+        {
+            Block &block = blocks[currentBlock];
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            size_t alignedOffset = ((base + currentOffset + alignment - 1) & ~(alignment - 1)) - base;
+            if (alignedOffset + size <= block.size)
+            {
+                currentOffset = alignedOffset + size;
+                return block.data.get() + alignedOffset;
+            }
+            currentBlock++;
+            currentOffset = 0;
+        }
+
+        // Grow, oversized requests get a block of their own
+        Block block;
+        block.size = std::max(blockSize, size + alignment);
+        block.data = std::unique_ptr<char[]>(new char[block.size]);
+        blocks.push_back(std::move(block));
+        blockAllocations++;
+        currentBlock = blocks.size() - 1;
+        currentOffset = 0;
+        return allocateBytes(size, alignment);
+    }
+};
@@ -1,12 +1,47 @@
 #pragma once
 
 #include "byte_buffer.h"
+#include "nbt_arena.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <initializer_list>
 
 const int MAX_NBT_DEPTH = 512;
 
+// Big-endian NBT array payload viewed in place, elements are converted on access
+template <typename T>
+class NBTArrayView
+{
+public:
+    NBTArrayView() : data_(nullptr), size_(0) {}
+    NBTArrayView(const char *data, size_t size) : data_(data), size_(size) {}
+
+    T operator[](size_t idx) const {
+        ByteBufferView element(data_ + idx * sizeof(T), sizeof(T));
+        return element.read<T>();
+    }
+
+    void copyTo(T *destination) const {
+        readBigEndianArray(data_, destination, size_);
+    }
+
+    void copyTo(T *destination, size_t count) const {
+        if (count > size_) {
+            throw std::out_of_range("Copy beyond array bounds");
+        }
+        readBigEndianArray(data_, destination, count);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    const char *data_;
+    size_t size_;
+};
+
 class NBTParser
 {
 public:
@@ -47,6 +82,104 @@ public:
         std::vector<uint64_t> longArrayValue;
     };
 
-    static NBTTag parseTag(ByteBuffer &buffer, TagType type, bool named = true, int currentDepth = 0);
-    static NBTTag parseNBT(ByteBuffer &buffer);
+    // Compact tree node allocated from an NBTArena. Names, strings and arrays point into the
+    // parsed buffer, so the buffer must outlive the tree. Children are stored contiguously.
+    struct NBTNode {
+        TagType type;
+        uint32_t length; // Children, array elements or string bytes
+        std::string_view name;
+
+        union {
+            int8_t byteValue;
+            int16_t shortValue;
+            int32_t intValue;
+            int64_t longValue;
+            float floatValue;
+            double doubleValue;
+            const char *payload;
+            const NBTNode *children;
+        };
+
+        const NBTNode *get(std::string_view childName) const;
+        const NBTNode *begin() const;
+        const NBTNode *end() const;
+        const NBTNode &operator[](size_t idx) const;
+        size_t size() const;
+
+        bool isNumber() const;
+        int64_t asLong() const;
+        int32_t asInt() const;
+        double asDouble() const;
+        std::string_view asString() const;
+        NBTArrayView<int8_t> asByteArray() const;
+        NBTArrayView<int32_t> asIntArray() const;
+        NBTArrayView<uint64_t> asLongArray() const;
+    };
+
+    // Streaming interface: receives one event per tag instead of a materialized tree.
+    // Names and strings point into the parsed buffer, array payloads are left big-endian.
+    class NBTVisitor
+    {
+    public:
+        virtual ~NBTVisitor() = default;
+
+        virtual void beginCompound(std::string_view /*name*/) {}
+        virtual void endCompound() {}
+        virtual void beginList(std::string_view /*name*/, TagType /*elementType*/, int32_t /*length*/) {}
+        virtual void endList() {}
+
+        virtual void byteValue(std::string_view /*name*/, int8_t /*value*/) {}
+        virtual void shortValue(std::string_view /*name*/, int16_t /*value*/) {}
+        virtual void intValue(std::string_view /*name*/, int32_t /*value*/) {}
+        virtual void longValue(std::string_view /*name*/, int64_t /*value*/) {}
+        virtual void floatValue(std::string_view /*name*/, float /*value*/) {}
+        virtual void doubleValue(std::string_view /*name*/, double /*value*/) {}
+        virtual void stringValue(std::string_view /*name*/, std::string_view /*value*/) {}
+
+        virtual void byteArray(std::string_view /*name*/, ByteBufferView /*payload*/, int32_t /*length*/) {}
+        virtual void intArray(std::string_view /*name*/, ByteBufferView /*payload*/, int32_t /*length*/) {}
+        virtual void longArray(std::string_view /*name*/, ByteBufferView /*payload*/, int32_t /*length*/) {}
+    };
+
+    // Compiled set of tag paths below the root, e.g. "sections/*/block_states/{palette,data}".
+    // "*" matches any compound key or list element and "{a,b}" matches any of the listed names.
+    // Tags that no path can reach are skipped by their encoded sizes without being parsed.
+    class NBTPathQuery
+    {
+    public:
+        static const int MATCH_ALL = -1;
+        static const int NO_MATCH = -2;
+
+        NBTPathQuery(std::initializer_list<std::string> paths);
+        NBTPathQuery(const std::vector<std::string> &paths);
+
+        int root() const;
+        int step(int node, std::string_view name) const;
+        bool isSelected(int node) const;
+
+    private:
+        struct Node
+        {
+            std::vector<std::pair<std::string, int>> children;
+            int wildcard = NO_MATCH;
+            bool terminal = false;
+        };
+        std::vector<Node> nodes;
+
+        void addPath(int node, const std::vector<std::vector<std::string>> &segments, size_t segmentIdx);
+        int addChild(int node, const std::string &name);
+        void mergeInto(int destination, int source);
+        void resolveWildcards(int node);
+    };
+
+    static NBTTag parseTag(ByteBufferView &buffer, TagType type, bool named = true, int currentDepth = 0);
+    static NBTTag parseNBT(ByteBufferView &buffer);
+    static const NBTNode *parseNBT(ByteBufferView &buffer, NBTArena &arena);
+    static const NBTNode *parseNBT(ByteBufferView &buffer, NBTArena &arena, const NBTPathQuery &query);
+    static void parseNBT(ByteBufferView &buffer, NBTVisitor &visitor);
+    static void parseNBT(ByteBufferView &buffer, NBTVisitor &visitor, const NBTPathQuery &query);
+    static void skipTag(ByteBufferView &buffer, TagType type, int currentDepth = 0);
+
+private:
+    static void visitTag(ByteBufferView &buffer, TagType type, std::string_view name, NBTVisitor &visitor, const NBTPathQuery *query, int queryNode, int currentDepth);
 };
\ No newline at end of file
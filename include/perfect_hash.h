@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a, the string is only read once per lookup. The final mix spreads the last characters
+// into the upper half, which picks the bucket: names sharing a long prefix clustered otherwise.
+constexpr uint64_t hashKey(std::string_view key)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (char c : key)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ULL;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Slot of a key hash under a bucket seed, mixed since FNV leaves the low bits poorly distributed
+constexpr uint32_t getPerfectHashSlot(uint64_t hash, uint32_t seed, size_t nSlots)
+{
+    hash ^= seed * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return static_cast<uint32_t>(hash) & static_cast<uint32_t>(nSlots - 1);
+}
+
+// Slot of a key in a table built by PerfectHash::build. Every key hashes to a slot of its own,
+// the caller compares the key stored there to reject names outside the table.
+constexpr uint32_t findPerfectHashSlot(std::string_view key, const uint32_t *seeds, size_t nBuckets, size_t nSlots)
+{
+    uint64_t hash = hashKey(key);
+    return getPerfectHashSlot(hash, seeds[(hash >> 32) % nBuckets], nSlots);
+}
+
+// Hash and displace: keys are grouped into buckets by the upper half of their hash, then each
+// bucket gets the seed that moves all its keys to free slots. Lookups cost one hash and one
+// comparison.
+class PerfectHash
+{
+public:
+    struct Table
+    {
+        std::vector<uint32_t> seeds; // Per bucket
+        std::vector<int32_t> slots;  // Key index, -1 when free. The size is a power of two.
+    };
+
+    // Throws std::invalid_argument on duplicate keys
+    static Table build(const std::vector<std::string_view> &keys);
+};
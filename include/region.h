@@ -1,26 +1,59 @@
 # pragma once
 
 #include <vector>
+#include <memory>
+#include <functional>
 #include "config.h"
-
-using RegionData = std::vector<std::vector<std::vector<std::vector<std::vector<std::vector<uint16_t>>>>>>;
+#include "section_data.h"
 
 class Region
 {
 public:
+    // Decodes the sections of a chunk, given in region chunk coordinates, bottom to top
+    using ChunkLoader = std::function<ChunkData(int chunkX, int chunkZ)>;
+
     Region(RegionData data, int regionXWorld, int regionZWorld);
+    // Lazy region, each chunk is decoded by chunkLoader the first time it is accessed
+    Region(ChunkLoader chunkLoader, int regionXWorld, int regionZWorld);
+    Region(Region &&other) noexcept;
     ~Region();
 
+    // Chunks a lazy region has not decoded yet are missing (null)
     const RegionData &getDataByRegion() const;
+    bool isLazy() const;
+    bool isChunkLoaded(int chunkX, int chunkZ) const;
+    // Decode a chunk of a lazy region ahead of its first access
+    void loadChunk(int chunkX, int chunkZ) const;
+    // Take the sections of a chunk source has decoded instead of decoding it again
+    void adoptChunk(const Region &source, int chunkX, int chunkZ);
+    // Missing sections return SectionData::getMissing()
     const SectionData &getSectionAt(int sx, int sy, int sz) const;
+    bool isSectionMissing(int sx, int sy, int sz) const;
+    bool isSectionUniform(int sx, int sy, int sz) const;
+    uint16_t getUniformBlockId(int sx, int sy, int sz) const;
     const uint16_t getBlockAt(int x, int y, int z) const;
     int getRegionXWorld() const;
     int getRegionZWorld() const;
     int getSizeX() const;
     int getSizeY() const;
     int getSizeZ() const;
+
+    // Bytes held by the section table and the paletted sections decoded so far. Uniform
+    // sections are shared between regions and not counted.
+    size_t getMemoryUsage() const;
+
+    static constexpr int getSectionIndex(int sx, int sy, int sz)
+    {
+        return (sx * N_CHUNKS_PER_REGION_XZ + sz) * N_SECTIONS_PER_CHUNK_Y + sy;
+    }
+
 private:
-    RegionData data;
+    struct LazyChunks;
+
+    void ensureChunkLoaded(int chunkX, int chunkZ) const;
+
+    mutable RegionData data; // Filled in chunk by chunk by lazy regions
+    std::unique_ptr<LazyChunks> lazyChunks;
     int regionXWorld;
     int regionZWorld;
 };
\ No newline at end of file
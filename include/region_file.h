@@ -0,0 +1,50 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only memory mapping of a .mca region file. Chunk sectors are handed out
+// as views into the mapping, so nothing is copied until a chunk is decoded.
+class RegionFile
+{
+public:
+    enum class AccessPattern
+    {
+        Normal,
+        Sequential,
+        Random,
+        WillNeed
+    };
+
+    RegionFile(const std::filesystem::path &filePath, AccessPattern accessPattern = AccessPattern::Sequential);
+    ~RegionFile();
+
+    RegionFile(const RegionFile &) = delete;
+    RegionFile &operator=(const RegionFile &) = delete;
+
+    void advise(AccessPattern accessPattern) const;
+    void advise(std::string_view range, AccessPattern accessPattern) const;
+
+    const char *data() const;
+    size_t size() const;
+    const std::filesystem::path &getPath() const;
+
+    uint32_t getChunkLocation(int chunkIdx) const;
+    // Last modification of a chunk in seconds since the epoch, from the second header sector
+    uint32_t getChunkTimestamp(int chunkIdx) const;
+    std::string_view getChunkSectors(int chunkIdx) const;
+
+private:
+    std::filesystem::path filePath;
+    const char *mappedData;
+    size_t mappedSize;
+
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
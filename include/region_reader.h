@@ -1,28 +1,57 @@
 #pragma once
 
 #include "region.h"
+#include "region_file.h"
 #include "config.h"
 #include "byte_buffer.h"
+#include "block_id_resolver.h"
+#include "section_disk_cache.h"
+#include "nbt_parser.h"
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <thread>
 #include <filesystem>
+#include <memory>
 
 namespace fs = std::filesystem;
 
+// Tags the reader needs from a chunk, everything else is skipped unparsed
+extern const NBTParser::NBTPathQuery CHUNK_QUERY;
+
 class RegionReader
 {
 public:
     static Region getRegion(
         const std::filesystem::path &filePath,
-        const std::unordered_map<std::string, uint16_t> &blockIdDict);
+        const std::unordered_map<std::string, uint16_t> &blockIdDict,
+        uint16_t unknownBlockId = 0xFFFF);
+    // Same, with a resolver that can be reused across regions
+    static Region getRegion(const std::filesystem::path &filePath, BlockIdResolver &blockIdResolver);
+
+    // Only reads the location table up front, chunks are decoded the first time they are accessed
+    static Region getLazyRegion(
+        const std::filesystem::path &filePath,
+        const std::unordered_map<std::string, uint16_t> &blockIdDict,
+        uint16_t unknownBlockId = 0xFFFF);
+    // Same, with a resolver shared by several regions. Chunks found in sectionDiskCache are loaded
+    // from it, the others are decoded and stored in it. Unknown block names are left tallied in
+    // the resolver for its owner to report.
+    static Region getLazyRegion(
+        const std::filesystem::path &filePath,
+        std::shared_ptr<BlockIdResolver> blockIdResolver,
+        std::shared_ptr<SectionDiskCache> sectionDiskCache = nullptr);
+
+    // Reads X and Z from a file named r.X.Z.mca, false for any other name
+    static bool parseRegionFileName(const std::filesystem::path &filePath, int &regionX, int &regionZ);
+
+    // Unpack a section's block_states data into TOTAL_SECTION_BLOCKS palette indices
+    static void processSection(const NBTArrayView<uint64_t> &data, int bitLength, uint16_t *blockIndices);
 
 private:
-    static std::vector<char> getRegionData(const std::filesystem::path &filePath);
-    static std::vector<uint32_t> getChunkLocationData(const std::vector<char> &regionData);
-    static std::vector<uint16_t> processSection(const std::vector<uint64_t> &data, int bitLength);
-    static ByteBuffer getChunkDataStream(const std::vector<uint32_t> &locations, int chunkIdx, const std::vector<char> &regionData);
-    static std::tuple<int, int, int, int, ChunkData> readAndProcessChunk(const ByteBuffer &chunkDataStream, const std::unordered_map<std::string, uint16_t> &blockIdDict);
-    static std::tuple<int, int> processChunks(const std::vector<uint32_t> &chunkLocationData, const std::vector<char> &regionData, const std::unordered_map<std::string, uint16_t> &blockIdDict, RegionData &data);
+    static std::vector<uint32_t> getChunkLocationData(const RegionFile &regionFile);
+    static ByteBufferView getChunkDataStream(const RegionFile &regionFile, int chunkIdx);
+    static std::tuple<int, int, int, int, ChunkData> readAndProcessChunk(const ByteBufferView &chunkDataStream, BlockIdResolver &blockIdResolver);
+    static ChunkData loadChunk(const RegionFile &regionFile, const std::vector<uint32_t> &chunkLocationData, BlockIdResolver &blockIdResolver, SectionDiskCache *sectionDiskCache, int chunkX, int chunkZ);
+    static std::tuple<int, int> processChunks(const std::vector<uint32_t> &chunkLocationData, const RegionFile &regionFile, BlockIdResolver &blockIdResolver, RegionData &data);
 };
\ No newline at end of file
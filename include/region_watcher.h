@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+// Reports the r.X.Z.mca files of a directory that were written to, from a background thread.
+// Uses inotify on Linux and polls modification times elsewhere or when inotify is unavailable.
+// Writes are reported once a file has been quiet for a moment, servers save chunks in bursts.
+class RegionWatcher
+{
+public:
+    using ChangeCallback = std::function<void(const std::filesystem::path &regionPath)>;
+
+    RegionWatcher(
+        const std::filesystem::path &regionDirectory,
+        ChangeCallback onChange,
+        std::chrono::milliseconds pollInterval = std::chrono::milliseconds(1000));
+    ~RegionWatcher();
+
+    RegionWatcher(const RegionWatcher &) = delete;
+    RegionWatcher &operator=(const RegionWatcher &) = delete;
+
+    bool isUsingInotify() const;
+
+private:
+    void watchInotify();
+    void watchPolling();
+
+    std::filesystem::path regionDirectory;
+    ChangeCallback onChange;
+    std::chrono::milliseconds pollInterval;
+    int inotifyDescriptor; // -1 when polling
+
+    std::thread watchThread;
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    bool stopWatching;
+};
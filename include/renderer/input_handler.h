@@ -16,12 +16,16 @@ public:
 
     void handleInput(Window &window, float deltaTime);
 
+    // Smoothed camera velocity in blocks per second
+    glm::vec3 getVelocity() const;
+
 private:
     // Input data
     float moveSpeed;
     float moveSpeedIncreaseFactor;
     float mouseSensitivity;
     bool developerKeyPressed;
+    glm::vec3 velocity;
 
     // Parent data
     Camera &camera;
@@ -2,7 +2,9 @@
 
 #include "opengl_headers.h"
 #include "window.h"
-#include "region.h"
+#include "world.h"
+#include "chunk_prefetcher.h"
+#include "section_mesher.h"
 #include "camera.h"
 #include "input_handler.h"
 #include "shader_setup.h"
@@ -14,14 +16,10 @@
 #include <thread>
 #include <mutex>
 #include <future>
+#include <memory>
 
 #define PI 3.14159265359f
 
-struct BlockFace {
-    glm::vec3 position;
-    uint8_t face; // 0=+X, 1=-X, 2=+Y, 3=-Y, 4=+Z, 5=-Z
-};
-
 class Renderer
 {
 public:
@@ -34,7 +32,8 @@ public:
     void startRenderLoop(Window &window);
 
     // Setters
-    void setRegion(Region *region);
+    // With watchChanges, sections are meshed again when the region files change on disk
+    void setWorld(World *world, bool watchChanges = false);
 
 private:
     Camera camera;
@@ -43,7 +42,9 @@ private:
     GeometrySetup geometrySetup;
 
     // Data
-    Region *region;
+    World *world;
+    std::unique_ptr<ChunkPrefetcher> chunkPrefetcher;
+    std::unique_ptr<SectionMesher> sectionMesher;
     std::unordered_map<uint16_t, glm::vec3> blockColorDict;
     std::vector<uint16_t> noRenderBlockIds;
 
@@ -64,7 +65,9 @@ private:
 
     void workerFunction();
     void queueSectionForProcessing(int sx, int sy, int sz, const std::string& sectionKey);
-    bool isSectionReady(const std::string& sectionKey);
+    // Last mesh built for the section, null until the first one is. Sections being meshed
+    // again return their previous mesh meanwhile.
+    std::shared_ptr<const std::unordered_map<uint16_t, std::vector<BlockFace>>> getSectionFaces(const std::string& sectionKey);
 
     std::thread sectionDiscoveryThread;
     std::atomic<bool> stopDiscoveryThread;
@@ -77,14 +80,17 @@ private:
     void sectionDiscoveryFunction();
     void startSectionDiscovery();
     void triggerSectionDiscoveryUpdate(const glm::ivec3& currentSectionPos, int sectionViewDistance);
+    void markSectionsChanged(const std::vector<std::tuple<int, int, int>> &sections);
 
     // Section cache
     struct SectionCache {
-        std::unordered_map<uint16_t, std::vector<BlockFace>> blockFaces;
+        std::shared_ptr<const std::unordered_map<uint16_t, std::vector<BlockFace>>> blockFaces; // Replaced whole, so a frame can keep drawing the previous one
         bool dirty;
         bool processing;
+        uint64_t version;       // Bumped when the blocks change on disk
+        uint64_t meshedVersion; // Version the faces were built from
 
-        SectionCache() : dirty(true), processing(false) {}
+        SectionCache() : dirty(true), processing(false), version(0), meshedVersion(0) {}
     };
     std::unordered_map<std::string, SectionCache> sectionCache;
 
@@ -97,7 +103,7 @@ private:
     void processSection(int sx, int sy, int sz, const std::string& sectionKey);
     void renderSection(const std::string& sectionKey, const glm::mat4& viewProjectionMatrix);
     void renderAllSections(std::unordered_map<uint8_t, std::unordered_map<uint8_t, std::vector<glm::vec3>>> allBlockPositions, std::unordered_map<uint8_t, glm::vec3> allBlockColors);
-    void drawRegion(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int sectionViewDistance = 32);
+    void drawWorld(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int sectionViewDistance = 32);
 
     // Rendering
     bool isRunning;
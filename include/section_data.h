@@ -0,0 +1,98 @@
+#pragma once
+
+#include "config.h"
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Blocks of one 16x16x16 section, stored close to the on-disk format: a local palette of the
+// block IDs in use plus one packed index per block, in YZX order. Index widths are powers of
+// two (1, 2, 4, 8 or 16 bits) so no index spans two longs and get() stays a shift and a mask.
+// Sections using a single block ID store no indices at all.
+class SectionData
+{
+public:
+    // Uniform section, missing (0xFFFF) by default
+    SectionData();
+    explicit SectionData(BlockId fill);
+
+    // Shared, immutable uniform section for a block ID, so uniform sections cost a pointer
+    static std::shared_ptr<const SectionData> getUniform(BlockId blockId);
+
+    // Stand-in for sections that were never generated, uniformly 0xFFFF
+    static const SectionData &getMissing();
+
+    // Packs blocks given as indices into paletteIds. Only the IDs actually used are kept,
+    // indices outside the palette become 0xFFFF.
+    SectionData(const std::vector<BlockId> &paletteIds, const uint16_t *indices);
+
+    // Takes storage as returned by getPalette() and getWords(). Throws std::invalid_argument
+    // if the words do not hold a power of two width or index past the palette.
+    SectionData(std::vector<BlockId> palette, std::vector<uint64_t> words);
+
+    static constexpr int getBlockIndex(int x, int y, int z)
+    {
+        return (y << (2 * SECTION_SHIFT)) | (z << SECTION_SHIFT) | x;
+    }
+
+    BlockId get(int x, int y, int z) const
+    {
+        if (bitsPerBlock == 0)
+        {
+            return palette[0];
+        }
+
+        int blockIdx = getBlockIndex(x, y, z);
+        uint64_t word = words[blockIdx >> (6 - bitsShift)];
+        int offset = (blockIdx << bitsShift) & 63;
+        return palette[(word >> offset) & ((1ULL << bitsPerBlock) - 1)];
+    }
+
+    // Write all TOTAL_SECTION_BLOCKS block IDs to output, in YZX order
+    void unpack(BlockId *output) const;
+
+    bool isUniform() const
+    {
+        return bitsPerBlock == 0;
+    }
+
+    int getBitsPerBlock() const
+    {
+        return bitsPerBlock;
+    }
+
+    const std::vector<BlockId> &getPalette() const
+    {
+        return palette;
+    }
+
+    const std::vector<uint64_t> &getWords() const
+    {
+        return words;
+    }
+
+    // Same blocks, the palette order follows from the blocks so storage can be compared directly
+    bool operator==(const SectionData &other) const
+    {
+        return bitsPerBlock == other.bitsPerBlock && palette == other.palette && words == other.words;
+    }
+    bool operator!=(const SectionData &other) const
+    {
+        return !(*this == other);
+    }
+
+    // Heap bytes held by the palette and the packed indices
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<BlockId> palette;
+    std::vector<uint64_t> words;
+    uint8_t bitsPerBlock;
+    uint8_t bitsShift; // log2(bitsPerBlock)
+};
+
+// Sections are shared and immutable once decoded. A null section is missing.
+using SectionPtr = std::shared_ptr<const SectionData>;
+using ChunkData = std::vector<SectionPtr>;  // Sections in a chunk, bottom to top
+using RegionData = std::vector<SectionPtr>; // Every section of a region, see Region::getSectionIndex
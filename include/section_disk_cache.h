@@ -0,0 +1,85 @@
+#pragma once
+
+#include "section_data.h"
+#include "region_file.h"
+#include "config.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// On-disk cache of the decoded sections of one region, in SectionData's own layout, so a cached
+// chunk loads with a few copies instead of inflating and parsing NBT. Chunks are keyed by their
+// timestamp and location in the region header, the whole file by the region path and the block
+// ID dictionary. The file is mapped read-only, written in native byte order, and rewritten with
+// the chunks stored since it was opened when the cache is flushed or destroyed.
+class SectionDiskCache
+{
+public:
+    enum class Compression : uint32_t
+    {
+        None = 0,
+        Zlib = 1
+    };
+
+    // A missing, stale or unreadable cache file starts out empty
+    SectionDiskCache(
+        const std::filesystem::path &cachePath,
+        const std::filesystem::path &regionPath,
+        uint64_t dictionaryHash,
+        Compression compression = Compression::None);
+    ~SectionDiskCache();
+
+    SectionDiskCache(const SectionDiskCache &) = delete;
+    SectionDiskCache &operator=(const SectionDiskCache &) = delete;
+
+    // Cache file of a region inside cacheDirectory
+    static std::filesystem::path getCachePath(const std::filesystem::path &cacheDirectory, const std::filesystem::path &regionPath);
+
+    // False unless the cache file holds the chunk with this timestamp and location
+    bool readChunk(int chunkIdx, uint32_t timestamp, uint32_t location, ChunkData &chunk) const;
+    // Safe to call from several workers at once
+    void storeChunk(int chunkIdx, uint32_t timestamp, uint32_t location, const ChunkData &chunk);
+
+    size_t getCachedChunkCount() const;
+
+    // Write the chunks stored since the file was mapped to a new file, replace the cache file with
+    // it and map it, so they no longer take memory. Chunks stored afterwards start over.
+    void flush();
+
+private:
+    struct ChunkEntry
+    {
+        uint32_t timestamp;
+        uint32_t location; // 0 if the chunk is not cached
+        uint32_t compression;
+        uint32_t rawSize;
+        uint64_t offset;
+        uint64_t storedSize;
+    };
+
+    static std::vector<char> serializeChunk(const ChunkData &chunk);
+    static ChunkData deserializeChunk(const char *data, size_t size);
+
+    // Map the cache file if it is valid for the region and dictionary, leaves it unmapped otherwise
+    void map();
+
+    std::filesystem::path cachePath;
+    std::string regionPath;
+    uint64_t dictionaryHash;
+    Compression compression;
+
+    // Replaced by flush() while evicted regions may still read from it
+    mutable std::shared_mutex mappingMutex;
+    std::unique_ptr<RegionFile> mapping; // Null without a valid cache file
+    std::vector<ChunkEntry> mappedEntries;
+
+    std::mutex storedMutex;
+    std::vector<ChunkEntry> storedEntries;
+    std::vector<std::vector<char>> storedChunks;
+    size_t nStoredChunks;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "world.h"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+struct BlockFace {
+    glm::vec3 position;
+    uint8_t face; // 0=+X, 1=-X, 2=+Y, 3=-Y, 4=+Z, 5=-Z
+};
+
+// Visible block faces of a section, without any GL so it can run on worker threads and in
+// benchmarks. A face is visible when the neighbouring block is missing or not rendered.
+class SectionMesher
+{
+public:
+    SectionMesher(const World &world, std::vector<uint16_t> noRenderBlockIds);
+
+    // Faces grouped by block ID, at global section coordinates
+    std::unordered_map<uint16_t, std::vector<BlockFace>> getSectionFaces(int sx, int sy, int sz) const;
+
+private:
+    const World &world;
+    std::vector<uint16_t> noRenderBlockIds;
+
+    bool isRenderableBlock(uint16_t blockId) const;
+    bool blockExists(int x, int y, int z) const;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "config.h"
+#include <cstddef>
+#include <cstdint>
+
+// Widest index a section can pack: palettes top out at 12 bits, direct block state IDs use more
+const int MAX_SECTION_BIT_LENGTH = 16;
+
+// Longs needed to pack a full section at the widest kernel width
+const int MAX_PACKED_SECTION_LONGS = TOTAL_SECTION_BLOCKS / (64 / MAX_SECTION_BIT_LENGTH);
+
+// Unpacks the indices of a section's packed long array into exactly TOTAL_SECTION_BLOCKS
+// entries. Indices never span two longs; blocks past the end of a short array are set to
+// 0xFFFF. A kernel is compiled for every bit length and the AVX2 variants are used when
+// the CPU has them.
+void unpackSectionIndices(const uint64_t *packed, size_t packedLength, int bitLength, uint16_t *output);
+
+// Name of the kernel family in use, for benchmarks and diagnostics
+const char *getSectionUnpackKernelName();
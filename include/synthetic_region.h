@@ -0,0 +1,52 @@
+#pragma once
+
+#include "chunk_decompressor.h"
+#include "config.h"
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// Maximum distinct blocks a section can hold, and the number of synthetic block names
+const int N_SYNTHETIC_BLOCKS = TOTAL_SECTION_BLOCKS;
+
+// Deterministic region files for benchmarks and stress tests. Everything is drawn from a
+// mt19937_64 without the standard distributions, whose results differ between standard
+// libraries, so the same options produce the same bytes on every machine.
+class SyntheticRegion
+{
+public:
+    enum class Pattern
+    {
+        Random,      // Every block draws a palette entry
+        Checkerboard // Air on odd x + y + z, so every solid block shows all six faces
+    };
+
+    struct Options
+    {
+        uint64_t seed = 42;
+        double chunkFillRatio = 1.0;                              // Chunks present in each region, the rest is left empty
+        double uniformSectionShare = 0.3;                         // Sections holding a single block
+        std::vector<int> paletteSizes = {2, 5, 16, 17, 40, 200}; // For the other sections, this sets their bit widths
+        std::vector<double> paletteSizeWeights;                   // Relative odds of each palette size, uniform when empty
+        Pattern pattern = Pattern::Random;
+        ChunkCompression compression = ChunkCompression::Zlib;
+    };
+
+    // Block names of the generated palettes, without the namespace. Block 0 is air.
+    static std::string getBlockName(int blockIdx);
+    // Every synthetic name mapped to its index
+    static std::unordered_map<std::string, uint16_t> getBlockIdDict();
+
+    // Uncompressed NBT of a chunk at global chunk coordinates, with the lighting and heightmaps
+    // a real chunk carries around its sections
+    static std::vector<char> makeChunkNBT(int chunkX, int chunkZ, const Options &options, std::mt19937_64 &random);
+    // Zlib, gzip, none, or LZ4 in lz4-java's block framing with stored (uncompressed) blocks
+    static std::vector<char> compressChunk(const std::vector<char> &nbt, ChunkCompression compression);
+
+    // Write the chunks of a region, chunk n is drawn from the seed and n. Whether it is present
+    // is drawn apart, so changing the fill ratio keeps the content of the remaining chunks.
+    static void writeRegionFile(const std::filesystem::path &filePath, int regionX, int regionZ, const Options &options);
+};
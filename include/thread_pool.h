@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Fixed set of worker threads running submitted tasks in submission order. Workers live as
+// long as the pool, so their thread_local state (decode contexts, scratch buffers) is reused.
+class ThreadPool
+{
+public:
+    // 0 threads sizes the pool to the hardware
+    explicit ThreadPool(size_t nThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Tasks must not throw, pending tasks still run on destruction
+    void submit(std::function<void()> task);
+    size_t getThreadCount() const;
+
+    // Pool shared by region decoding, created on first use
+    static ThreadPool &getShared();
+
+private:
+    void workerFunction();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    bool stopWorkers;
+};
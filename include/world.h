@@ -0,0 +1,139 @@
+#pragma once
+
+#include "region.h"
+#include "block_id_resolver.h"
+#include "section_disk_cache.h"
+#include "region_watcher.h"
+#include "section_data.h"
+#include "config.h"
+#include <filesystem>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <string>
+#include <utility>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <tuple>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Every region of a world, indexed by the coordinates in their r.X.Z.mca file names. Regions
+// are mapped the first time they are accessed and decode their chunks lazily. Coordinates are
+// global: x and z are world block (or section) coordinates across region boundaries, y counts
+// from the bottom of the world (MIN_Y) as in Region.
+//
+// Loaded regions form an LRU cache under a memory budget. The viewer streams regions around
+// the camera with updateFocus(), which loads them in the background and evicts the regions
+// focused least recently while over budget.
+//
+// In watch mode, region files rewritten on disk are reloaded chunk by chunk: chunks whose
+// location and timestamp in the region header are unchanged carry over as they are.
+class World
+{
+public:
+    World(const std::filesystem::path &regionDirectory, const std::unordered_map<std::string, uint16_t> &blockIdDict, uint16_t unknownBlockId = 0xFFFF);
+    World(const std::filesystem::path &regionDirectory, std::shared_ptr<BlockIdResolver> blockIdResolver);
+    ~World();
+
+    World(const World &) = delete;
+    World &operator=(const World &) = delete;
+
+    // Outside every region blocks are missing (0xFFFF) and sections return SectionData::getMissing()
+    BlockId getBlockAt(int x, int y, int z) const;
+    // The section belongs to its region, the reference is only valid until the next lookup on
+    // this thread and while the region is not evicted or reloaded. Hold getRegion() to keep it.
+    const SectionData &getSectionAt(int sx, int sy, int sz) const;
+    bool isSectionMissing(int sx, int sy, int sz) const;
+    bool isSectionUniform(int sx, int sy, int sz) const;
+    BlockId getUniformBlockId(int sx, int sy, int sz) const;
+
+    // Decode a chunk, given in global chunk coordinates, ahead of its first access
+    void loadChunk(int chunkX, int chunkZ) const;
+
+    // Loads the region if needed. Null if the world has no region file at these region
+    // coordinates or it failed to open. An evicted region stays valid while it is held.
+    std::shared_ptr<const Region> getRegion(int regionX, int regionZ) const;
+    std::vector<std::pair<int, int>> getRegionCoordinates() const;
+    size_t getRegionCount() const;
+    size_t getLoadedRegionCount() const;
+
+    // Load the regions within radius blocks of (x, z) on the shared thread pool, then evict
+    // while over the memory budget. Returns immediately, later calls supersede pending ones.
+    void updateFocus(int x, int z, int radius);
+    void setMemoryBudget(size_t bytes);
+
+    // Keep decoded sections in cache files under cacheDirectory, for the regions first opened afterwards
+    void setCacheDirectory(const std::filesystem::path &cacheDirectory, SectionDiskCache::Compression compression = SectionDiskCache::Compression::None);
+
+    // Reread the header of a region file and reload the chunks whose location or timestamp
+    // changed. Returns the global coordinates of the sections whose blocks may have changed.
+    std::vector<std::tuple<int, int, int>> refreshRegion(const std::filesystem::path &regionPath);
+
+    // Refresh regions as their files are written, onSectionsChanged runs on the watcher thread
+    using SectionsChangedCallback = std::function<void(const std::vector<std::tuple<int, int, int>> &sections)>;
+    void startWatching(SectionsChangedCallback onSectionsChanged);
+    void stopWatching();
+
+    // Block bounds of the indexed regions, max exclusive
+    int getMinX() const;
+    int getMaxX() const;
+    int getMinZ() const;
+    int getMaxZ() const;
+    int getSizeY() const;
+
+    // Region holding a block or section coordinate, rounding down for negative coordinates
+    static constexpr int getRegionOfBlock(int blockCoordinate)
+    {
+        return blockCoordinate >> (REGION_SHIFT + SECTION_SHIFT);
+    }
+    static constexpr int getRegionOfSection(int sectionCoordinate)
+    {
+        return sectionCoordinate >> REGION_SHIFT;
+    }
+
+private:
+    struct RegionSlot;
+
+    static int64_t getRegionKey(int regionX, int regionZ);
+    RegionSlot *addRegionSlot(int regionX, int regionZ, const std::filesystem::path &filePath);
+    RegionSlot *findRegionSlot(int regionX, int regionZ) const;
+    const Region *findRegion(int regionX, int regionZ) const;
+    void streamRegions();
+    void evictRegions(uint64_t focusTime);
+    void reportUnknownBlocks(bool force) const;
+
+    std::filesystem::path regionDirectory;
+    std::shared_ptr<BlockIdResolver> blockIdResolver;
+    mutable std::atomic<int64_t> lastUnknownBlockReport; // Steady clock, in seconds
+
+    // Guards the index and the bounds, slots are only ever added
+    mutable std::shared_mutex regionsMutex;
+    std::unordered_map<int64_t, std::unique_ptr<RegionSlot>> regions;
+    int minRegionX;
+    int maxRegionX;
+    int minRegionZ;
+    int maxRegionZ;
+
+    // Region cache
+    uint64_t worldId;
+    std::atomic<size_t> memoryBudget;
+    mutable std::atomic<uint64_t> accessClock;
+    std::atomic<uint64_t> regionGeneration; // Bumped when a region is added, evicted or reloaded
+    std::filesystem::path cacheDirectory;
+    SectionDiskCache::Compression cacheCompression;
+
+    // Streaming, at most one task is queued and it picks up the latest focus
+    std::mutex streamMutex;
+    std::condition_variable streamCondition;
+    bool streamQueued;
+    bool focusPending;
+    int focusX;
+    int focusZ;
+    int focusRadius;
+
+    std::unique_ptr<RegionWatcher> regionWatcher;
+};
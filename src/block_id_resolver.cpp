@@ -0,0 +1,113 @@
+#include "block_id_resolver.h"
+#include <vector>
+#include <algorithm>
+
+const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+BlockIdResolver::BlockIdResolver(const std::unordered_map<std::string, uint16_t> &blockIdDict, uint16_t fallbackId, size_t maxReportedNames)
+    : findTableBlockId(nullptr), entries(blockIdDict.begin(), blockIdDict.end()), fallbackId(fallbackId), maxReportedNames(maxReportedNames)
+{
+    std::sort(entries.begin(), entries.end());
+
+    std::vector<std::pair<std::string_view, uint16_t>> entryViews(entries.begin(), entries.end());
+    dictionaryHash = hashDictionary(entryViews, fallbackId);
+
+    std::vector<std::string_view> names;
+    names.reserve(entries.size());
+    for (const auto &[name, blockId] : entries)
+    {
+        names.push_back(name);
+    }
+    table = PerfectHash::build(names);
+}
+
+uint64_t BlockIdResolver::hashDictionary(std::vector<std::pair<std::string_view, uint16_t>> entries, uint16_t fallbackId)
+{
+    // Hash the entries in name order, neither the map's nor the table's order is meaningful
+    std::sort(entries.begin(), entries.end());
+
+    uint64_t hash = hashBytes(FNV_OFFSET_BASIS, &fallbackId, sizeof(fallbackId));
+    for (const auto &[name, blockId] : entries)
+    {
+        // Separate the names, so "ab" + "c" and "a" + "bc" differ
+        const char terminator = '\0';
+        hash = hashBytes(hash, name.data(), name.size());
+        hash = hashBytes(hash, &terminator, 1);
+        hash = hashBytes(hash, &blockId, sizeof(blockId));
+    }
+    return hash;
+}
+
+uint16_t BlockIdResolver::resolve(std::string_view blockName)
+{
+    if (findTableBlockId)
+    {
+        int32_t blockId = findTableBlockId(blockName);
+        if (blockId >= 0)
+        {
+            return static_cast<uint16_t>(blockId);
+        }
+    }
+    else
+    {
+        int32_t entryIdx = table.slots[findPerfectHashSlot(blockName, table.seeds.data(), table.seeds.size(), table.slots.size())];
+        if (entryIdx >= 0 && entries[entryIdx].first == blockName)
+        {
+            return entries[entryIdx].second;
+        }
+    }
+
+    // Unknown blocks are rare, the lock is only taken for them
+    std::lock_guard<std::mutex> lock(unknownMutex);
+    unknownCounts[std::string(blockName)]++;
+    return fallbackId;
+}
+
+void BlockIdResolver::reportUnknownBlocks(std::ostream &out)
+{
+    std::vector<std::pair<std::string, size_t>> unknownBlocks;
+    {
+        std::lock_guard<std::mutex> lock(unknownMutex);
+        unknownBlocks.assign(unknownCounts.begin(), unknownCounts.end());
+        unknownCounts.clear();
+    }
+    if (unknownBlocks.empty())
+    {
+        return;
+    }
+
+    // Most frequent first, only the first few are listed
+    std::sort(unknownBlocks.begin(), unknownBlocks.end(), [](const auto &a, const auto &b)
+              { return a.second != b.second ? a.second > b.second : a.first < b.first; });
+
+    out << "Unknown blocks found: " << unknownBlocks.size() << " distinct names, mapped to ID " << fallbackId << std::endl;
+    for (size_t i = 0; i < std::min(maxReportedNames, unknownBlocks.size()); ++i)
+    {
+        out << "  " << unknownBlocks[i].first << " (" << unknownBlocks[i].second << " sections)" << std::endl;
+    }
+    if (unknownBlocks.size() > maxReportedNames)
+    {
+        out << "  ... and " << unknownBlocks.size() - maxReportedNames << " more" << std::endl;
+    }
+}
+
+uint16_t BlockIdResolver::getFallbackId() const
+{
+    return fallbackId;
+}
+
+uint64_t BlockIdResolver::getDictionaryHash() const
+{
+    return dictionaryHash;
+}
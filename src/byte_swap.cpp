@@ -0,0 +1,160 @@
+#include "byte_swap.h"
+#include "cpu_features.h"
+#include <cstdlib>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_IS_BIG_ENDIAN
+#endif
+
+using ByteSwapKernel = void (*)(const char *source, char *destination, size_t count);
+
+/*****
+ ****
+ *** Scalar kernels
+ ****
+ ******/
+
+template <typename T>
+static T swapBytes(T value)
+{
+#ifdef _MSC_VER
+    if constexpr (sizeof(T) == 2) { return _byteswap_ushort(value); }
+    else if constexpr (sizeof(T) == 4) { return _byteswap_ulong(value); }
+    else { return _byteswap_uint64(value); }
+#else
+    if constexpr (sizeof(T) == 2) { return __builtin_bswap16(value); }
+    else if constexpr (sizeof(T) == 4) { return __builtin_bswap32(value); }
+    else { return __builtin_bswap64(value); }
+#endif
+}
+
+template <typename T>
+static void byteSwapScalar(const char *source, char *destination, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        T value;
+        std::memcpy(&value, source + i * sizeof(T), sizeof(T));
+#ifndef HOST_IS_BIG_ENDIAN
+        value = swapBytes(value);
+#endif
+        std::memcpy(destination + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#ifdef SIMD_X86
+
+/*****
+ ****
+ *** SIMD kernels
+ ****
+ ******/
+
+// Byte shuffle reversing every element of the given size within a 16 byte lane
+template <size_t ElementSize>
+static const char *getShuffleMask()
+{
+    alignas(16) static const char masks[3][16] = {
+        {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+        {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+        {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8}};
+    return masks[ElementSize == 2 ? 0 : (ElementSize == 4 ? 1 : 2)];
+}
+
+template <typename T>
+TARGET_SSSE3 static void byteSwapSSSE3(const char *source, char *destination, size_t count)
+{
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i *>(getShuffleMask<sizeof(T)>()));
+    size_t bytes = count * sizeof(T);
+    size_t offset = 0;
+
+    for (; offset + 16 <= bytes; offset += 16)
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + offset), _mm_shuffle_epi8(value, mask));
+    }
+
+    byteSwapScalar<T>(source + offset, destination + offset, (bytes - offset) / sizeof(T));
+}
+
+template <typename T>
+TARGET_AVX2 static void byteSwapAVX2(const char *source, char *destination, size_t count)
+{
+    // vpshufb works per 128-bit lane, so both lanes use the same mask
+    const __m128i laneMask = _mm_load_si128(reinterpret_cast<const __m128i *>(getShuffleMask<sizeof(T)>()));
+    const __m256i mask = _mm256_broadcastsi128_si256(laneMask);
+    size_t bytes = count * sizeof(T);
+    size_t offset = 0;
+
+    for (; offset + 64 <= bytes; offset += 64)
+    {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + offset));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + offset + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + offset), _mm256_shuffle_epi8(first, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + offset + 32), _mm256_shuffle_epi8(second, mask));
+    }
+    for (; offset + 32 <= bytes; offset += 32)
+    {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + offset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + offset), _mm256_shuffle_epi8(value, mask));
+    }
+
+    byteSwapScalar<T>(source + offset, destination + offset, (bytes - offset) / sizeof(T));
+}
+
+#endif
+
+/*****
+ ****
+ *** Dispatch
+ ****
+ ******/
+
+struct ByteSwapKernels
+{
+    ByteSwapKernel swap16;
+    ByteSwapKernel swap32;
+    ByteSwapKernel swap64;
+    const char *name;
+};
+
+static ByteSwapKernels selectByteSwapKernels()
+{
+#if defined(SIMD_X86) && !defined(HOST_IS_BIG_ENDIAN)
+    if (cpuHasAVX2())
+    {
+        return {byteSwapAVX2<uint16_t>, byteSwapAVX2<uint32_t>, byteSwapAVX2<uint64_t>, "avx2"};
+    }
+    if (cpuHasSSSE3())
+    {
+        return {byteSwapSSSE3<uint16_t>, byteSwapSSSE3<uint32_t>, byteSwapSSSE3<uint64_t>, "ssse3"};
+    }
+#endif
+    return {byteSwapScalar<uint16_t>, byteSwapScalar<uint32_t>, byteSwapScalar<uint64_t>, "scalar"};
+}
+
+static const ByteSwapKernels &getByteSwapKernels()
+{
+    static const ByteSwapKernels kernels = selectByteSwapKernels();
+    return kernels;
+}
+
+void byteSwap16(const char *source, uint16_t *destination, size_t count)
+{
+    getByteSwapKernels().swap16(source, reinterpret_cast<char *>(destination), count);
+}
+
+void byteSwap32(const char *source, uint32_t *destination, size_t count)
+{
+    getByteSwapKernels().swap32(source, reinterpret_cast<char *>(destination), count);
+}
+
+void byteSwap64(const char *source, uint64_t *destination, size_t count)
+{
+    getByteSwapKernels().swap64(source, reinterpret_cast<char *>(destination), count);
+}
+
+const char *getByteSwapKernelName()
+{
+    return getByteSwapKernels().name;
+}
@@ -0,0 +1,124 @@
+#include "chunk_decode_context.h"
+#include <atomic>
+#include <mutex>
+
+static std::atomic<uint64_t> totalChunks(0);
+static std::atomic<uint64_t> totalDecompressorSetups(0);
+static std::atomic<uint64_t> totalBufferGrowths(0);
+static std::atomic<uint64_t> totalArenaBlockAllocations(0);
+static std::atomic<bool> stageTimingEnabled(false);
+
+// Stage counters of every context, kept after their thread exits so no time is lost
+static std::mutex stageCountersMutex;
+static std::vector<std::shared_ptr<const DecodeStageCounters>> allStageCounters;
+
+ChunkDecodeContext::ChunkDecodeContext() : stageCounters(std::make_shared<DecodeStageCounters>()), stageTiming(false)
+{
+    std::lock_guard<std::mutex> lock(stageCountersMutex);
+    allStageCounters.push_back(stageCounters);
+}
+
+ChunkDecodeContext &ChunkDecodeContext::forCurrentThread()
+{
+    thread_local ChunkDecodeContext context;
+    return context;
+}
+
+void ChunkDecodeContext::beginChunk()
+{
+    arena.reset();
+    totalChunks.fetch_add(1, std::memory_order_relaxed);
+    stageTiming = stageTimingEnabled.load(std::memory_order_relaxed);
+}
+
+void ChunkDecodeContext::setStageTiming(bool enabled)
+{
+    stageTimingEnabled = enabled;
+}
+
+bool ChunkDecodeContext::isStageTiming()
+{
+    return stageTimingEnabled;
+}
+
+std::chrono::steady_clock::time_point ChunkDecodeContext::beginStage() const
+{
+    return stageTiming ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+void ChunkDecodeContext::endStage(DecodeStage stage, std::chrono::steady_clock::time_point start, uint64_t bytes)
+{
+    if (!stageTiming)
+    {
+        return;
+    }
+
+    // Only this worker writes its counters, no read-modify-write is needed
+    size_t stageIdx = static_cast<size_t>(stage);
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    std::atomic<uint64_t> &stageNanoseconds = stageCounters->nanoseconds[stageIdx];
+    std::atomic<uint64_t> &stageBytes = stageCounters->bytes[stageIdx];
+    stageNanoseconds.store(stageNanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    stageBytes.store(stageBytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+}
+
+ByteBufferView ChunkDecodeContext::decompress(uint8_t compressionType, const ByteBufferView &input)
+{
+    ChunkDecompressor &decompressor = getDecompressor(compressionType);
+
+    const char *previousData = output.data();
+    ByteBufferView result = decompressor.decompress(input, output);
+    if (output.data() != previousData)
+    {
+        totalBufferGrowths.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+const NBTParser::NBTNode *ChunkDecodeContext::parse(ByteBufferView &nbt, const NBTParser::NBTPathQuery &query)
+{
+    size_t blockAllocations = arena.getBlockAllocations();
+    const NBTParser::NBTNode *root = NBTParser::parseNBT(nbt, arena, query);
+    totalArenaBlockAllocations.fetch_add(arena.getBlockAllocations() - blockAllocations, std::memory_order_relaxed);
+
+    return root;
+}
+
+ChunkDecompressor &ChunkDecodeContext::getDecompressor(uint8_t compressionType)
+{
+    // Unknown types go straight to the factory, which reports them
+    if (compressionType >= decompressors.size())
+    {
+        ChunkDecompressor::create(compressionType);
+    }
+
+    std::unique_ptr<ChunkDecompressor> &decompressor = decompressors[compressionType];
+    if (!decompressor)
+    {
+        decompressor = ChunkDecompressor::create(compressionType);
+        totalDecompressorSetups.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return *decompressor;
+}
+
+ChunkDecodeStats ChunkDecodeContext::getTotalStats()
+{
+    ChunkDecodeStats stats;
+    stats.chunks = totalChunks.load(std::memory_order_relaxed);
+    stats.decompressorSetups = totalDecompressorSetups.load(std::memory_order_relaxed);
+    stats.bufferGrowths = totalBufferGrowths.load(std::memory_order_relaxed);
+    stats.arenaBlockAllocations = totalArenaBlockAllocations.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(stageCountersMutex);
+    for (const std::shared_ptr<const DecodeStageCounters> &counters : allStageCounters)
+    {
+        for (size_t stageIdx = 0; stageIdx < N_DECODE_STAGES; ++stageIdx)
+        {
+            stats.stageNanoseconds[stageIdx] += counters->nanoseconds[stageIdx].load(std::memory_order_relaxed);
+            stats.stageBytes[stageIdx] += counters->bytes[stageIdx].load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
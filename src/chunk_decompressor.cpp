@@ -0,0 +1,327 @@
+#include "chunk_decompressor.h"
+#include <zlib/zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+const size_t MIN_OUTPUT_BYTES = 64 * 1024;
+const size_t ZLIB_EXPANSION_GUESS = 6;
+const size_t DEFLATE_MAX_EXPANSION = 1032; // Deflate cannot expand its input more than this
+const int GZIP_WINDOW_BITS = 16 + MAX_WBITS;
+const size_t GZIP_TRAILER_BYTES = 8;
+
+const char LZ4_BLOCK_MAGIC[] = {'L', 'Z', '4', 'B', 'l', 'o', 'c', 'k'};
+const size_t LZ4_BLOCK_MAGIC_BYTES = sizeof(LZ4_BLOCK_MAGIC);
+const size_t LZ4_BLOCK_HEADER_BYTES = LZ4_BLOCK_MAGIC_BYTES + 1 + 4 + 4 + 4;
+const uint8_t LZ4_METHOD_RAW = 0x10;
+const uint8_t LZ4_METHOD_LZ4 = 0x20;
+const size_t LZ4_MIN_MATCH = 4;
+const int LZ4_MIN_BLOCK_SHIFT = 10; // Block size is 1 << (10 + level)
+
+static uint32_t readLittleEndian32(const char *data)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    return static_cast<uint32_t>(bytes[0]) |
+           (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) |
+           (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+std::unique_ptr<ChunkDecompressor> ChunkDecompressor::create(uint8_t compressionType)
+{
+    if (compressionType & EXTERNAL_CHUNK_FLAG)
+    {
+        throw std::runtime_error("Chunks stored in external .mcc files are not supported");
+    }
+
+    switch (static_cast<ChunkCompression>(compressionType))
+    {
+    case ChunkCompression::Gzip:
+        return std::make_unique<GzipChunkDecompressor>();
+    case ChunkCompression::Zlib:
+        return std::make_unique<ZlibChunkDecompressor>();
+    case ChunkCompression::Uncompressed:
+        return std::make_unique<UncompressedChunkDecompressor>();
+    case ChunkCompression::LZ4:
+        return std::make_unique<LZ4ChunkDecompressor>();
+    default:
+        throw std::runtime_error("Unsupported chunk compression type: " + std::to_string(compressionType));
+    }
+}
+
+/*****
+ ****
+ *** Zlib and gzip
+ ****
+ ******/
+
+ZlibChunkDecompressor::ZlibChunkDecompressor() : stream(std::make_unique<z_stream>()), streamWindowBits(0)
+{
+}
+
+ZlibChunkDecompressor::~ZlibChunkDecompressor()
+{
+    if (streamWindowBits != 0)
+    {
+        inflateEnd(stream.get());
+    }
+}
+
+ByteBufferView ZlibChunkDecompressor::decompress(const ByteBufferView &input, std::vector<char> &output)
+{
+    return inflateSingleShot(input, output, MAX_WBITS, input.size() * ZLIB_EXPANSION_GUESS);
+}
+
+void ZlibChunkDecompressor::prepareStream(int windowBits)
+{
+    // Resetting keeps the inflate state and window allocated, only the first chunk pays for them
+    if (streamWindowBits != 0)
+    {
+        if (inflateReset2(stream.get(), windowBits) == Z_OK)
+        {
+            streamWindowBits = windowBits;
+            return;
+        }
+        inflateEnd(stream.get());
+        streamWindowBits = 0;
+    }
+
+    std::memset(stream.get(), 0, sizeof(z_stream));
+    if (inflateInit2(stream.get(), windowBits) != Z_OK)
+    {
+        throw std::runtime_error("Failed to initialize zlib inflation");
+    }
+    streamWindowBits = windowBits;
+}
+
+ByteBufferView ZlibChunkDecompressor::inflateSingleShot(const ByteBufferView &input, std::vector<char> &output, int windowBits, size_t expectedSize)
+{
+    prepareStream(windowBits);
+    z_stream &zstream = *stream;
+
+    // Size the output once up front, it only grows again if the guess was too small. The guess
+    // can come from the data, so it is capped.
+    size_t initialSize = std::min(std::max(expectedSize, MIN_OUTPUT_BYTES), MAX_CHUNK_BYTES);
+    if (output.size() < initialSize)
+    {
+        output.resize(initialSize);
+    }
+
+    zstream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.bytes()));
+    zstream.avail_in = static_cast<uInt>(input.size());
+
+    while (true)
+    {
+        size_t produced = zstream.total_out;
+        zstream.next_out = reinterpret_cast<Bytef *>(output.data() + produced);
+        zstream.avail_out = static_cast<uInt>(std::min<size_t>(output.size() - produced, std::numeric_limits<uInt>::max()));
+
+        int ret = inflate(&zstream, Z_FINISH);
+        if (ret == Z_STREAM_END)
+        {
+            break;
+        }
+
+        bool outputFull = zstream.avail_out == 0;
+        if ((ret == Z_OK || ret == Z_BUF_ERROR) && outputFull)
+        {
+            if (output.size() >= MAX_CHUNK_BYTES)
+            {
+                throw std::runtime_error("Decompressed chunk larger than " + std::to_string(MAX_CHUNK_BYTES) + " bytes");
+            }
+            output.resize(std::min(output.size() * 2, MAX_CHUNK_BYTES));
+            continue;
+        }
+
+        throw std::runtime_error(zstream.avail_in == 0 ? "Truncated compressed chunk data" : "Failed to decompress chunk data");
+    }
+
+    return ByteBufferView(output.data(), zstream.total_out);
+}
+
+ByteBufferView GzipChunkDecompressor::decompress(const ByteBufferView &input, std::vector<char> &output)
+{
+    // The gzip trailer ends with the decompressed size modulo 2^32, only used as a first guess
+    size_t expectedSize = input.size() * ZLIB_EXPANSION_GUESS;
+    if (input.size() >= GZIP_TRAILER_BYTES)
+    {
+        expectedSize = std::min<size_t>(readLittleEndian32(input.bytes() + input.size() - 4), input.size() * DEFLATE_MAX_EXPANSION);
+    }
+
+    return inflateSingleShot(input, output, GZIP_WINDOW_BITS, expectedSize);
+}
+
+/*****
+ ****
+ *** Uncompressed
+ ****
+ ******/
+
+ByteBufferView UncompressedChunkDecompressor::decompress(const ByteBufferView &input, std::vector<char> &/*output*/)
+{
+    // Nothing to do, the NBT is read straight from the region data
+    return ByteBufferView(input.bytes(), input.size());
+}
+
+/*****
+ ****
+ *** LZ4
+ ****
+ ******/
+
+ByteBufferView LZ4ChunkDecompressor::decompress(const ByteBufferView &input, std::vector<char> &output)
+{
+    const char *data = input.bytes();
+    size_t size = input.size();
+
+    size_t produced = 0;
+    for (size_t offset = 0; offset + LZ4_BLOCK_HEADER_BYTES <= size;)
+    {
+        if (std::memcmp(data + offset, LZ4_BLOCK_MAGIC, LZ4_BLOCK_MAGIC_BYTES) != 0)
+        {
+            throw std::runtime_error("Invalid LZ4 block magic");
+        }
+        uint8_t token = static_cast<uint8_t>(data[offset + LZ4_BLOCK_MAGIC_BYTES]);
+        uint8_t method = token & 0xF0;
+        uint32_t compressedLength = readLittleEndian32(data + offset + LZ4_BLOCK_MAGIC_BYTES + 1);
+        uint32_t blockLength = readLittleEndian32(data + offset + LZ4_BLOCK_MAGIC_BYTES + 5);
+        offset += LZ4_BLOCK_HEADER_BYTES;
+
+        // End of stream marker
+        if (blockLength == 0)
+        {
+            break;
+        }
+        if (compressedLength > size - offset)
+        {
+            throw std::runtime_error("Truncated LZ4 block");
+        }
+
+        // The low nibble of the token sets the block size the stream was written with
+        if (blockLength > (size_t(1) << (LZ4_MIN_BLOCK_SHIFT + (token & 0x0F))))
+        {
+            throw std::runtime_error("LZ4 block longer than its stream's block size");
+        }
+        if (blockLength > MAX_CHUNK_BYTES - produced)
+        {
+            throw std::runtime_error("Decompressed chunk larger than " + std::to_string(MAX_CHUNK_BYTES) + " bytes");
+        }
+
+        // Grow with the blocks instead of trusting their lengths up front
+        if (output.size() < produced + blockLength)
+        {
+            output.resize(std::min(std::max({produced + blockLength, output.size() * 2, MIN_OUTPUT_BYTES}), MAX_CHUNK_BYTES));
+        }
+
+        if (method == LZ4_METHOD_RAW)
+        {
+            if (compressedLength != blockLength)
+            {
+                throw std::runtime_error("Invalid raw LZ4 block length");
+            }
+            std::memcpy(output.data() + produced, data + offset, blockLength);
+        }
+        else if (method == LZ4_METHOD_LZ4)
+        {
+            size_t blockProduced = decompressBlock(data + offset, compressedLength, output.data() + produced, blockLength);
+            if (blockProduced != blockLength)
+            {
+                throw std::runtime_error("LZ4 block decompressed to an unexpected length");
+            }
+        }
+        else
+        {
+            throw std::runtime_error("Unsupported LZ4 block method");
+        }
+
+        produced += blockLength;
+        offset += compressedLength;
+    }
+
+    return ByteBufferView(output.data(), produced);
+}
+
+size_t LZ4ChunkDecompressor::decompressBlock(const char *input, size_t inputSize, char *output, size_t outputSize)
+{
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(input);
+    const uint8_t *inputEnd = ip + inputSize;
+    char *op = output;
+    char *outputEnd = output + outputSize;
+
+    auto readLength = [&](size_t length) -> size_t
+    {
+        // Lengths of 15 continue in the following bytes, each 255 meaning "more follows"
+        if (length == 15)
+        {
+            uint8_t extra;
+            do
+            {
+                if (ip >= inputEnd)
+                {
+                    throw std::runtime_error("Truncated LZ4 sequence length");
+                }
+                extra = *ip++;
+                length += extra;
+            } while (extra == 255);
+        }
+        return length;
+    };
+
+    while (ip < inputEnd)
+    {
+        uint8_t token = *ip++;
+
+        // Literals
+        size_t literalLength = readLength(token >> 4);
+        if (literalLength > static_cast<size_t>(inputEnd - ip) || literalLength > static_cast<size_t>(outputEnd - op))
+        {
+            throw std::runtime_error("LZ4 literals out of bounds");
+        }
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence only has literals
+        if (ip == inputEnd)
+        {
+            break;
+        }
+
+        // Match
+        if (inputEnd - ip < 2)
+        {
+            throw std::runtime_error("Truncated LZ4 match offset");
+        }
+        size_t matchOffset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (matchOffset == 0 || matchOffset > static_cast<size_t>(op - output))
+        {
+            throw std::runtime_error("Invalid LZ4 match offset");
+        }
+
+        size_t matchLength = readLength(token & 0x0F) + LZ4_MIN_MATCH;
+        if (matchLength > static_cast<size_t>(outputEnd - op))
+        {
+            throw std::runtime_error("LZ4 match out of bounds");
+        }
+
+        const char *match = op - matchOffset;
+        if (matchOffset >= matchLength)
+        {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            // Overlapping match, repeats the last matchOffset bytes
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return static_cast<size_t>(op - output);
+}
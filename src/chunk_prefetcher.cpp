@@ -0,0 +1,106 @@
+#include "chunk_prefetcher.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+const int MAX_PREFETCH_STEPS = 64;
+const size_t MAX_PREFETCH_CHUNKS = 4096;
+
+ChunkPrefetcher::ChunkPrefetcher(World &world, float lookaheadSeconds, size_t maxWorkers)
+    : world(world), lookaheadSeconds(lookaheadSeconds), maxWorkers(std::max<size_t>(1, maxWorkers)), nActiveWorkers(0)
+{
+}
+
+ChunkPrefetcher::~ChunkPrefetcher()
+{
+    // Drop the queue and wait for the chunks being decoded
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    pendingChunks.clear();
+    workersCondition.wait(lock, [this]()
+                          { return nActiveWorkers == 0; });
+}
+
+void ChunkPrefetcher::update(float x, float z, float velocityX, float velocityZ, int radius)
+{
+    // Sample the trajectory about once per chunk travelled
+    float distance = std::sqrt(velocityX * velocityX + velocityZ * velocityZ) * lookaheadSeconds;
+    int nSteps = std::min(MAX_PREFETCH_STEPS, static_cast<int>(std::ceil(distance / SECTION_SIZE)));
+    int chunkRadius = (radius + SECTION_SIZE - 1) / SECTION_SIZE;
+    float radiusSquared = static_cast<float>(radius) * radius;
+
+    auto isInView = [&](int chunkX, int chunkZ, float centerX, float centerZ)
+    {
+        float dx = (chunkX + 0.5f) * SECTION_SIZE - centerX;
+        float dz = (chunkZ + 0.5f) * SECTION_SIZE - centerZ;
+        return dx * dx + dz * dz <= radiusSquared;
+    };
+
+    // Chunks entering the view at each step, the ones in view now are already being meshed
+    std::deque<std::pair<int, int>> plannedChunks;
+    std::unordered_set<int64_t> plannedKeys;
+    for (int step = 1; step <= nSteps && plannedChunks.size() < MAX_PREFETCH_CHUNKS; ++step)
+    {
+        float t = lookaheadSeconds * step / nSteps;
+        float centerX = x + velocityX * t;
+        float centerZ = z + velocityZ * t;
+        int centerChunkX = static_cast<int>(std::floor(centerX / SECTION_SIZE));
+        int centerChunkZ = static_cast<int>(std::floor(centerZ / SECTION_SIZE));
+
+        for (int chunkX = centerChunkX - chunkRadius; chunkX <= centerChunkX + chunkRadius; ++chunkX)
+        {
+            for (int chunkZ = centerChunkZ - chunkRadius; chunkZ <= centerChunkZ + chunkRadius; ++chunkZ)
+            {
+                if (!isInView(chunkX, chunkZ, centerX, centerZ) || isInView(chunkX, chunkZ, x, z))
+                {
+                    continue;
+                }
+
+                int64_t key = (static_cast<int64_t>(chunkX) << 32) | static_cast<uint32_t>(chunkZ);
+                if (plannedKeys.insert(key).second)
+                {
+                    plannedChunks.emplace_back(chunkX, chunkZ);
+                }
+            }
+        }
+    }
+
+    // Replace the previous plan, its chunks that were not started are cancelled
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pendingChunks = std::move(plannedChunks);
+    while (nActiveWorkers < maxWorkers && nActiveWorkers < pendingChunks.size())
+    {
+        nActiveWorkers++;
+        ThreadPool::getShared().submit([this]()
+                                       { workerFunction(); });
+    }
+}
+
+size_t ChunkPrefetcher::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return pendingChunks.size();
+}
+
+void ChunkPrefetcher::workerFunction()
+{
+    while (true)
+    {
+        std::pair<int, int> chunk;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            if (pendingChunks.empty())
+            {
+                // Notify under the lock, the destructor may be waiting
+                nActiveWorkers--;
+                workersCondition.notify_all();
+                return;
+            }
+
+            chunk = pendingChunks.front();
+            pendingChunks.pop_front();
+        }
+
+        world.loadChunk(chunk.first, chunk.second);
+    }
+}
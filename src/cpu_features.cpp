@@ -0,0 +1,57 @@
+#include "cpu_features.h"
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+struct CpuFeatures
+{
+    bool hasSSSE3;
+    bool hasAVX2;
+};
+
+static CpuFeatures detectCpuFeatures()
+{
+    CpuFeatures features = {false, false};
+
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    if (maxLeaf >= 1)
+    {
+        __cpuid(info, 1);
+        features.hasSSSE3 = (info[2] & (1 << 9)) != 0;
+        bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+        bool hasAVX = (info[2] & (1 << 28)) != 0;
+        if (maxLeaf >= 7 && hasOSXSAVE && hasAVX && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            features.hasAVX2 = (info[1] & (1 << 5)) != 0;
+        }
+    }
+#elif defined(SIMD_X86)
+    __builtin_cpu_init();
+    features.hasSSSE3 = __builtin_cpu_supports("ssse3");
+    features.hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+    return features;
+}
+
+static const CpuFeatures &getCpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+bool cpuHasSSSE3()
+{
+    return getCpuFeatures().hasSSSE3;
+}
+
+bool cpuHasAVX2()
+{
+    return getCpuFeatures().hasAVX2;
+}
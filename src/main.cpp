@@ -10,56 +10,104 @@
 #include <iostream>
 #include "window.h"
 #include "renderer/renderer.h"
-#include "region_reader.h"
+#include "world.h"
+#include "block_table.h"
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
 #define WINDOW_WIDTH 1920
 #define WINDOW_HEIGHT 1080
+#define REGION_CACHE_BUDGET_MB 2048
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    // Get file paths
+    // Get file paths and options
     fs::path globalDir = fs::current_path().parent_path();
-    fs::path regionFilePath = globalDir / "data" / "r.0.0_2.mca";
-    fs::path blockIdDictFilePath = globalDir / "data" / "block_id_dictionary.json";
-    fs::path blockColorDictFilePath = globalDir / "data" / "block_color_dictionary.json";
-
-    // Get block id dictionary
-    std::ifstream blockIdDictFile(blockIdDictFilePath);
-    if (!blockIdDictFile.is_open())
-    {
-        throw std::runtime_error("Failed to open block id dictionary file: " + blockIdDictFilePath.string());
-    }
-    json blockIdDictJson = json::parse(blockIdDictFile);
-    std::unordered_map<std::string, uint16_t> blockIdDict;
-    for (auto it = blockIdDictJson.begin(); it != blockIdDictJson.end(); ++it)
+    fs::path regionDirectory = globalDir / "data" / "region";
+    fs::path blockDictionaryDirectory;
+    bool watchChanges = false;
+    for (int i = 1; i < argc; ++i)
     {
-        blockIdDict[it.key()] = static_cast<uint16_t>(it.value());
+        std::string argument = argv[i];
+        if (argument == "--watch")
+        {
+            watchChanges = true;
+        }
+        else if (argument == "--block-dictionaries" && i + 1 < argc)
+        {
+            blockDictionaryDirectory = argv[++i];
+        }
+        else
+        {
+            regionDirectory = argument;
+        }
     }
 
-    // Get block color dictionary
-    std::ifstream blockColorDictFile(blockColorDictFilePath);
-    if (!blockColorDictFile.is_open())
-    {
-        throw std::runtime_error("Failed to open block color dictionary file: " + blockColorDictFilePath.string());
-    }
-    json blockColorDictJson = json::parse(blockColorDictFile);
+    // Block IDs and colors are compiled in, the JSON dictionaries override them
+    std::shared_ptr<BlockIdResolver> blockIdResolver;
     std::unordered_map<uint16_t, glm::vec3> blockColorDict;
-    for (auto it = blockColorDictJson.begin(); it != blockColorDictJson.end(); ++it)
+    std::vector<uint16_t> noRenderBlockIds = {};
+    if (blockDictionaryDirectory.empty() && BlockTable::getBlockCount() > 0)
     {
-        int blockId = blockIdDict[it.key()];
-        blockColorDict[blockId] = glm::vec3(it.value()[0], it.value()[1], it.value()[2]);
+        blockIdResolver = std::make_shared<BlockIdResolver>(BlockTable());
+        for (size_t i = 0; i < BlockTable::getBlockCount(); ++i)
+        {
+            const BlockInfo &block = BlockTable::getBlock(i);
+            if (block.flags & BLOCK_HAS_COLOR)
+            {
+                blockColorDict[block.id] = glm::vec3(block.color[0], block.color[1], block.color[2]);
+            }
+            if (block.flags & BLOCK_NO_RENDER)
+            {
+                noRenderBlockIds.push_back(block.id);
+            }
+        }
     }
+    else
+    {
+        if (blockDictionaryDirectory.empty())
+        {
+            blockDictionaryDirectory = globalDir / "data";
+        }
+        fs::path blockIdDictFilePath = blockDictionaryDirectory / "block_id_dictionary.json";
+        fs::path blockColorDictFilePath = blockDictionaryDirectory / "block_color_dictionary.json";
 
-    // Get no render block id list
-    std::vector<uint16_t> noRenderBlockIds = {};
-    noRenderBlockIds.push_back(blockIdDict["air"]);
+        // Get block id dictionary
+        std::unordered_map<std::string, uint16_t> blockIdDict;
+        std::ifstream blockIdDictFile(blockIdDictFilePath);
+        if (!blockIdDictFile.is_open())
+        {
+            throw std::runtime_error("Failed to open block id dictionary file: " + blockIdDictFilePath.string());
+        }
+        json blockIdDictJson = json::parse(blockIdDictFile);
+        for (auto it = blockIdDictJson.begin(); it != blockIdDictJson.end(); ++it)
+        {
+            blockIdDict[it.key()] = static_cast<uint16_t>(it.value());
+        }
+
+        // Get block color dictionary
+        std::ifstream blockColorDictFile(blockColorDictFilePath);
+        if (!blockColorDictFile.is_open())
+        {
+            throw std::runtime_error("Failed to open block color dictionary file: " + blockColorDictFilePath.string());
+        }
+        json blockColorDictJson = json::parse(blockColorDictFile);
+        for (auto it = blockColorDictJson.begin(); it != blockColorDictJson.end(); ++it)
+        {
+            int blockId = blockIdDict[it.key()];
+            blockColorDict[blockId] = glm::vec3(it.value()[0], it.value()[1], it.value()[2]);
+        }
+
+        // Get no render block id list
+        noRenderBlockIds.push_back(blockIdDict["air"]);
+        blockIdResolver = std::make_shared<BlockIdResolver>(blockIdDict);
+    }
 
-    // Get region
-    RegionReader region_reader = RegionReader();
-    Region region = region_reader.getRegion(regionFilePath, blockIdDict);
+    // Get world, regions and their chunks are decoded the first time the renderer reaches them
+    World world(regionDirectory, blockIdResolver);
+    world.setMemoryBudget(size_t(REGION_CACHE_BUDGET_MB) * 1024 * 1024);
+    world.setCacheDirectory(globalDir / "cache");
 
     // Initialize window
     Window window(WINDOW_WIDTH, WINDOW_HEIGHT, "Blocksage");
@@ -78,7 +126,7 @@ int main(void)
         glfwTerminate();
         return -1;
     }
-    renderer.setRegion(&region);
+    renderer.setWorld(&world, watchChanges);
     renderer.startRenderLoop(window);
 
     window.cleanup();
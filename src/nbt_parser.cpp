@@ -1,7 +1,8 @@
 #include "nbt_parser.h"
 #include <iostream>
+#include <algorithm>
 
-NBTParser::NBTTag NBTParser::parseTag(ByteBuffer &buffer, TagType type, bool named, int currentDepth) {
+NBTParser::NBTTag NBTParser::parseTag(ByteBufferView &buffer, TagType type, bool named, int currentDepth) {
     if (currentDepth > MAX_NBT_DEPTH) {
         throw std::runtime_error("NBT depth exceeds maximum depth");
     }
@@ -66,24 +67,19 @@ NBTParser::NBTTag NBTParser::parseTag(ByteBuffer &buffer, TagType type, bool nam
                     break;
                 }
                 NBTTag compound = parseTag(buffer, compoundType, true, currentDepth + 1);
-                tag.compoundValue[compound.name] = compound;
+                std::string compoundName = compound.name;
+                tag.compoundValue[std::move(compoundName)] = std::move(compound);
             }
             break;
         }
         case TagType::TagIntArray: {
             int32_t intArrayLength = buffer.read<int32_t>();
-            tag.intArrayValue.resize(intArrayLength);
-            for (int i = 0; i < intArrayLength; i++) {
-                tag.intArrayValue[i] = buffer.read<int32_t>();
-            }
+            tag.intArrayValue = buffer.readVector<int32_t>(std::max(intArrayLength, 0));
             break;
         }
         case TagType::TagLongArray: {
-            uint32_t longArrayLength = buffer.read<uint32_t>();
-            tag.longArrayValue.resize(longArrayLength);
-            for (int i = 0; i < longArrayLength; i++) {
-                tag.longArrayValue[i] = buffer.read<uint64_t>();
-            }
+            int32_t longArrayLength = buffer.read<int32_t>();
+            tag.longArrayValue = buffer.readVector<uint64_t>(std::max(longArrayLength, 0));
             break;
         }
     }
@@ -91,11 +87,528 @@ NBTParser::NBTTag NBTParser::parseTag(ByteBuffer &buffer, TagType type, bool nam
     return tag;
 }
 
-NBTParser::NBTTag NBTParser::parseNBT(ByteBuffer &buffer) {
+NBTParser::NBTTag NBTParser::parseNBT(ByteBufferView &buffer) {
     TagType rootType = static_cast<TagType>(buffer.read<uint8_t>());
     if (rootType != TagType::TagCompound) {
         throw std::runtime_error("Root tag must be a compound tag");
     }
 
     return parseTag(buffer, rootType);
-}
\ No newline at end of file
+}
+
+NBTParser::NBTPathQuery::NBTPathQuery(std::initializer_list<std::string> paths)
+    : NBTPathQuery(std::vector<std::string>(paths)) {}
+
+NBTParser::NBTPathQuery::NBTPathQuery(const std::vector<std::string> &paths) {
+    nodes.emplace_back();
+
+    for (const std::string &path : paths) {
+        // Split the path into segments, each segment into its alternatives
+        std::vector<std::vector<std::string>> segments;
+        size_t segmentStart = 0;
+        while (segmentStart <= path.size()) {
+            size_t segmentEnd = path.find('/', segmentStart);
+            if (segmentEnd == std::string::npos) {
+                segmentEnd = path.size();
+            }
+            std::string segment = path.substr(segmentStart, segmentEnd - segmentStart);
+            segmentStart = segmentEnd + 1;
+
+            std::vector<std::string> alternatives;
+            if (segment.size() >= 2 && segment.front() == '{' && segment.back() == '}') {
+                size_t alternativeStart = 1;
+                while (alternativeStart < segment.size()) {
+                    size_t alternativeEnd = segment.find(',', alternativeStart);
+                    if (alternativeEnd == std::string::npos) {
+                        alternativeEnd = segment.size() - 1;
+                    }
+                    alternatives.push_back(segment.substr(alternativeStart, alternativeEnd - alternativeStart));
+                    alternativeStart = alternativeEnd + 1;
+                }
+            } else {
+                alternatives.push_back(segment);
+            }
+            segments.push_back(alternatives);
+        }
+
+        addPath(root(), segments, 0);
+    }
+
+    resolveWildcards(root());
+}
+
+int NBTParser::NBTPathQuery::root() const {
+    return 0;
+}
+
+int NBTParser::NBTPathQuery::step(int node, std::string_view name) const {
+    if (node < 0 || nodes[node].terminal) {
+        return node == NO_MATCH ? NO_MATCH : MATCH_ALL;
+    }
+
+    for (const auto &[childName, child] : nodes[node].children) {
+        if (childName == name) {
+            return child;
+        }
+    }
+    return nodes[node].wildcard;
+}
+
+bool NBTParser::NBTPathQuery::isSelected(int node) const {
+    return node == MATCH_ALL || (node >= 0 && nodes[node].terminal);
+}
+
+void NBTParser::NBTPathQuery::addPath(int node, const std::vector<std::vector<std::string>> &segments, size_t segmentIdx) {
+    if (segmentIdx == segments.size()) {
+        nodes[node].terminal = true;
+        return;
+    }
+
+    for (const std::string &alternative : segments[segmentIdx]) {
+        int child = addChild(node, alternative);
+        addPath(child, segments, segmentIdx + 1);
+    }
+}
+
+int NBTParser::NBTPathQuery::addChild(int node, const std::string &name) {
+    if (name == "*") {
+        if (nodes[node].wildcard == NO_MATCH) {
+            nodes[node].wildcard = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+        }
+        return nodes[node].wildcard;
+    }
+
+    for (const auto &[childName, child] : nodes[node].children) {
+        if (childName == name) {
+            return child;
+        }
+    }
+    int child = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes[node].children.emplace_back(name, child);
+    return child;
+}
+
+void NBTParser::NBTPathQuery::mergeInto(int destination, int source) {
+    if (nodes[source].terminal) {
+        nodes[destination].terminal = true;
+    }
+
+    // Copy by index, addChild may reallocate the node storage
+    for (size_t i = 0; i < nodes[source].children.size(); ++i) {
+        std::string childName = nodes[source].children[i].first;
+        int sourceChild = nodes[source].children[i].second;
+        mergeInto(addChild(destination, childName), sourceChild);
+    }
+    if (nodes[source].wildcard != NO_MATCH) {
+        int sourceWildcard = nodes[source].wildcard;
+        mergeInto(addChild(destination, "*"), sourceWildcard);
+    }
+}
+
+void NBTParser::NBTPathQuery::resolveWildcards(int node) {
+    // A named child must also match everything its wildcard sibling matches, so that step stays deterministic
+    int wildcard = nodes[node].wildcard;
+    if (wildcard != NO_MATCH) {
+        for (size_t i = 0; i < nodes[node].children.size(); ++i) {
+            mergeInto(nodes[node].children[i].second, wildcard);
+        }
+    }
+
+    for (size_t i = 0; i < nodes[node].children.size(); ++i) {
+        resolveWildcards(nodes[node].children[i].second);
+    }
+    if (wildcard != NO_MATCH) {
+        resolveWildcards(wildcard);
+    }
+}
+
+void NBTParser::skipTag(ByteBufferView &buffer, TagType type, int currentDepth) {
+    if (currentDepth > MAX_NBT_DEPTH) {
+        throw std::runtime_error("NBT depth exceeds maximum depth");
+    }
+
+    switch (type) {
+        case TagType::TagEnd:
+            break;
+        case TagType::TagByte:
+            buffer.skip(sizeof(int8_t));
+            break;
+        case TagType::TagShort:
+            buffer.skip(sizeof(int16_t));
+            break;
+        case TagType::TagInt:
+        case TagType::TagFloat:
+            buffer.skip(sizeof(int32_t));
+            break;
+        case TagType::TagLong:
+        case TagType::TagDouble:
+            buffer.skip(sizeof(int64_t));
+            break;
+        case TagType::TagByteArray:
+            buffer.skip(static_cast<size_t>(std::max(buffer.read<int32_t>(), 0)));
+            break;
+        case TagType::TagString:
+            buffer.skip(buffer.read<uint16_t>());
+            break;
+        case TagType::TagList: {
+            TagType listType = static_cast<TagType>(buffer.read<int8_t>());
+            int32_t listLength = std::max(buffer.read<int32_t>(), 0);
+
+            // Lists of fixed size elements are skipped in one step
+            size_t elementSize = 0;
+            switch (listType) {
+                case TagType::TagByte: elementSize = sizeof(int8_t); break;
+                case TagType::TagShort: elementSize = sizeof(int16_t); break;
+                case TagType::TagInt: elementSize = sizeof(int32_t); break;
+                case TagType::TagFloat: elementSize = sizeof(float); break;
+                case TagType::TagLong: elementSize = sizeof(int64_t); break;
+                case TagType::TagDouble: elementSize = sizeof(double); break;
+                default: break;
+            }
+            if (elementSize > 0 || listType == TagType::TagEnd) {
+                buffer.skip(static_cast<size_t>(listLength) * elementSize);
+                break;
+            }
+
+            for (int i = 0; i < listLength; ++i) {
+                skipTag(buffer, listType, currentDepth + 1);
+            }
+            break;
+        }
+        case TagType::TagCompound: {
+            while (true) {
+                TagType compoundType = static_cast<TagType>(buffer.read<uint8_t>());
+                if (compoundType == TagType::TagEnd) {
+                    break;
+                }
+                buffer.skip(buffer.read<uint16_t>());
+                skipTag(buffer, compoundType, currentDepth + 1);
+            }
+            break;
+        }
+        case TagType::TagIntArray:
+            buffer.skip(static_cast<size_t>(std::max(buffer.read<int32_t>(), 0)) * sizeof(int32_t));
+            break;
+        case TagType::TagLongArray:
+            buffer.skip(static_cast<size_t>(std::max(buffer.read<int32_t>(), 0)) * sizeof(int64_t));
+            break;
+        default:
+            throw std::runtime_error("Unknown NBT tag type: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+void NBTParser::visitTag(ByteBufferView &buffer, TagType type, std::string_view name, NBTVisitor &visitor, const NBTPathQuery *query, int queryNode, int currentDepth) {
+    if (currentDepth > MAX_NBT_DEPTH) {
+        throw std::runtime_error("NBT depth exceeds maximum depth");
+    }
+
+    // Values are only reported when selected, containers also when a selected path runs through them
+    bool isContainer = type == TagType::TagList || type == TagType::TagCompound;
+    if (query && !isContainer && !query->isSelected(queryNode)) {
+        skipTag(buffer, type, currentDepth);
+        return;
+    }
+
+    switch (type) {
+        case TagType::TagEnd:
+            break;
+        case TagType::TagByte:
+            visitor.byteValue(name, buffer.read<int8_t>());
+            break;
+        case TagType::TagShort:
+            visitor.shortValue(name, buffer.read<int16_t>());
+            break;
+        case TagType::TagInt:
+            visitor.intValue(name, buffer.read<int32_t>());
+            break;
+        case TagType::TagLong:
+            visitor.longValue(name, buffer.read<int64_t>());
+            break;
+        case TagType::TagFloat:
+            visitor.floatValue(name, buffer.read<float>());
+            break;
+        case TagType::TagDouble:
+            visitor.doubleValue(name, buffer.read<double>());
+            break;
+        case TagType::TagByteArray: {
+            int32_t byteArrayLength = buffer.read<int32_t>();
+            if (byteArrayLength < 0) {
+                throw std::runtime_error("Negative NBT array length");
+            }
+            visitor.byteArray(name, buffer.readView(byteArrayLength), byteArrayLength);
+            break;
+        }
+        case TagType::TagString: {
+            uint16_t stringLength = buffer.read<uint16_t>();
+            visitor.stringValue(name, buffer.readStringView(stringLength));
+            break;
+        }
+        case TagType::TagList: {
+            TagType listType = static_cast<TagType>(buffer.read<int8_t>());
+            int32_t listLength = std::max(buffer.read<int32_t>(), 0);
+            visitor.beginList(name, listType, listLength);
+            int elementNode = query ? query->step(queryNode, std::string_view()) : NBTPathQuery::MATCH_ALL;
+            for (int i = 0; i < listLength; ++i) {
+                if (elementNode == NBTPathQuery::NO_MATCH) {
+                    skipTag(buffer, listType, currentDepth + 1);
+                } else {
+                    visitTag(buffer, listType, std::string_view(), visitor, query, elementNode, currentDepth + 1);
+                }
+            }
+            visitor.endList();
+            break;
+        }
+        case TagType::TagCompound: {
+            visitor.beginCompound(name);
+            while (true) {
+                TagType compoundType = static_cast<TagType>(buffer.read<uint8_t>());
+                if (compoundType == TagType::TagEnd) {
+                    break;
+                }
+                uint16_t nameLength = buffer.read<uint16_t>();
+                std::string_view compoundName = buffer.readStringView(nameLength);
+                int childNode = query ? query->step(queryNode, compoundName) : NBTPathQuery::MATCH_ALL;
+                if (childNode == NBTPathQuery::NO_MATCH) {
+                    skipTag(buffer, compoundType, currentDepth + 1);
+                } else {
+                    visitTag(buffer, compoundType, compoundName, visitor, query, childNode, currentDepth + 1);
+                }
+            }
+            visitor.endCompound();
+            break;
+        }
+        case TagType::TagIntArray: {
+            int32_t intArrayLength = buffer.read<int32_t>();
+            if (intArrayLength < 0) {
+                throw std::runtime_error("Negative NBT array length");
+            }
+            visitor.intArray(name, buffer.readView(static_cast<size_t>(intArrayLength) * sizeof(int32_t)), intArrayLength);
+            break;
+        }
+        case TagType::TagLongArray: {
+            int32_t longArrayLength = buffer.read<int32_t>();
+            if (longArrayLength < 0) {
+                throw std::runtime_error("Negative NBT array length");
+            }
+            visitor.longArray(name, buffer.readView(static_cast<size_t>(longArrayLength) * sizeof(int64_t)), longArrayLength);
+            break;
+        }
+        default:
+            throw std::runtime_error("Unknown NBT tag type: " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+void NBTParser::parseNBT(ByteBufferView &buffer, NBTVisitor &visitor) {
+    TagType rootType = static_cast<TagType>(buffer.read<uint8_t>());
+    if (rootType != TagType::TagCompound) {
+        throw std::runtime_error("Root tag must be a compound tag");
+    }
+
+    uint16_t nameLength = buffer.read<uint16_t>();
+    std::string_view rootName = buffer.readStringView(nameLength);
+    visitTag(buffer, rootType, rootName, visitor, nullptr, NBTPathQuery::MATCH_ALL, 0);
+}
+
+void NBTParser::parseNBT(ByteBufferView &buffer, NBTVisitor &visitor, const NBTPathQuery &query) {
+    TagType rootType = static_cast<TagType>(buffer.read<uint8_t>());
+    if (rootType != TagType::TagCompound) {
+        throw std::runtime_error("Root tag must be a compound tag");
+    }
+
+    uint16_t nameLength = buffer.read<uint16_t>();
+    std::string_view rootName = buffer.readStringView(nameLength);
+    visitTag(buffer, rootType, rootName, visitor, &query, query.root(), 0);
+}
+
+// Builds an NBTNode tree from visitor events. Open containers keep their children on a
+// scratch stack, which is copied into a contiguous arena array once the container ends.
+class NBTTreeBuilder : public NBTParser::NBTVisitor
+{
+public:
+    NBTTreeBuilder(NBTArena &arena) : arena(arena), scratch(nullptr), scratchSize(0), scratchCapacity(0), depth(0) {}
+
+    const NBTParser::NBTNode *getRoot() const { return root; }
+
+    void beginCompound(std::string_view name) override { beginContainer(NBTParser::TagType::TagCompound, name); }
+    void endCompound() override { endContainer(); }
+    void beginList(std::string_view name, NBTParser::TagType /*elementType*/, int32_t /*length*/) override { beginContainer(NBTParser::TagType::TagList, name); }
+    void endList() override { endContainer(); }
+
+    void byteValue(std::string_view name, int8_t value) override { push(NBTParser::TagType::TagByte, name).byteValue = value; }
+    void shortValue(std::string_view name, int16_t value) override { push(NBTParser::TagType::TagShort, name).shortValue = value; }
+    void intValue(std::string_view name, int32_t value) override { push(NBTParser::TagType::TagInt, name).intValue = value; }
+    void longValue(std::string_view name, int64_t value) override { push(NBTParser::TagType::TagLong, name).longValue = value; }
+    void floatValue(std::string_view name, float value) override { push(NBTParser::TagType::TagFloat, name).floatValue = value; }
+    void doubleValue(std::string_view name, double value) override { push(NBTParser::TagType::TagDouble, name).doubleValue = value; }
+    void stringValue(std::string_view name, std::string_view value) override { pushPayload(NBTParser::TagType::TagString, name, value.data(), value.size()); }
+    void byteArray(std::string_view name, ByteBufferView payload, int32_t length) override { pushPayload(NBTParser::TagType::TagByteArray, name, payload.bytes(), length); }
+    void intArray(std::string_view name, ByteBufferView payload, int32_t length) override { pushPayload(NBTParser::TagType::TagIntArray, name, payload.bytes(), length); }
+    void longArray(std::string_view name, ByteBufferView payload, int32_t length) override { pushPayload(NBTParser::TagType::TagLongArray, name, payload.bytes(), length); }
+
+private:
+    NBTArena &arena;
+    NBTParser::NBTNode *scratch;
+    size_t scratchSize;
+    size_t scratchCapacity;
+    size_t childStarts[MAX_NBT_DEPTH + 2];
+    int depth;
+    const NBTParser::NBTNode *root = nullptr;
+
+    NBTParser::NBTNode &push(NBTParser::TagType type, std::string_view name)
+    {
+        // Grow the scratch stack inside the arena, the old copy is released with the tree
+        if (scratchSize == scratchCapacity)
+        {
+            size_t newCapacity = std::max<size_t>(64, scratchCapacity * 2);
+            NBTParser::NBTNode *newScratch = arena.allocate<NBTParser::NBTNode>(newCapacity);
+            std::copy(scratch, scratch + scratchSize, newScratch);
+            scratch = newScratch;
+            scratchCapacity = newCapacity;
+        }
+
+        NBTParser::NBTNode &node = scratch[scratchSize++];
+        node.type = type;
+        node.length = 0;
+        node.name = name;
+        node.longValue = 0;
+        return node;
+    }
+
+    void pushPayload(NBTParser::TagType type, std::string_view name, const char *payload, size_t length)
+    {
+        NBTParser::NBTNode &node = push(type, name);
+        node.payload = payload;
+        node.length = static_cast<uint32_t>(length);
+    }
+
+    void beginContainer(NBTParser::TagType type, std::string_view name)
+    {
+        push(type, name);
+        childStarts[depth++] = scratchSize;
+    }
+
+    void endContainer()
+    {
+        size_t childStart = childStarts[--depth];
+        size_t childCount = scratchSize - childStart;
+
+        NBTParser::NBTNode *children = arena.allocate<NBTParser::NBTNode>(childCount);
+        std::copy(scratch + childStart, scratch + scratchSize, children);
+        scratchSize = childStart;
+
+        NBTParser::NBTNode &container = scratch[childStart - 1];
+        container.children = children;
+        container.length = static_cast<uint32_t>(childCount);
+
+        // The root compound is the last container to end
+        if (depth == 0)
+        {
+            NBTParser::NBTNode *rootNode = arena.allocate<NBTParser::NBTNode>(1);
+            *rootNode = container;
+            root = rootNode;
+            scratchSize = 0;
+        }
+    }
+};
+
+const NBTParser::NBTNode *NBTParser::NBTNode::get(std::string_view childName) const {
+    if (type != TagType::TagCompound) {
+        return nullptr;
+    }
+
+    for (const NBTNode &child : *this) {
+        if (child.name == childName) {
+            return &child;
+        }
+    }
+    return nullptr;
+}
+
+const NBTParser::NBTNode *NBTParser::NBTNode::begin() const {
+    return (type == TagType::TagCompound || type == TagType::TagList) ? children : nullptr;
+}
+
+const NBTParser::NBTNode *NBTParser::NBTNode::end() const {
+    return (type == TagType::TagCompound || type == TagType::TagList) ? children + length : nullptr;
+}
+
+const NBTParser::NBTNode &NBTParser::NBTNode::operator[](size_t idx) const {
+    if (idx >= size()) {
+        throw std::out_of_range("NBT child index out of range");
+    }
+    return children[idx];
+}
+
+size_t NBTParser::NBTNode::size() const {
+    return length;
+}
+
+bool NBTParser::NBTNode::isNumber() const {
+    return type >= TagType::TagByte && type <= TagType::TagDouble;
+}
+
+int64_t NBTParser::NBTNode::asLong() const {
+    switch (type) {
+        case TagType::TagByte: return byteValue;
+        case TagType::TagShort: return shortValue;
+        case TagType::TagInt: return intValue;
+        case TagType::TagLong: return longValue;
+        case TagType::TagFloat: return static_cast<int64_t>(floatValue);
+        case TagType::TagDouble: return static_cast<int64_t>(doubleValue);
+        default: throw std::runtime_error("NBT tag is not a number: " + std::string(name));
+    }
+}
+
+int32_t NBTParser::NBTNode::asInt() const {
+    return static_cast<int32_t>(asLong());
+}
+
+double NBTParser::NBTNode::asDouble() const {
+    switch (type) {
+        case TagType::TagFloat: return floatValue;
+        case TagType::TagDouble: return doubleValue;
+        default: return static_cast<double>(asLong());
+    }
+}
+
+std::string_view NBTParser::NBTNode::asString() const {
+    if (type != TagType::TagString) {
+        throw std::runtime_error("NBT tag is not a string: " + std::string(name));
+    }
+    return std::string_view(payload, length);
+}
+
+NBTArrayView<int8_t> NBTParser::NBTNode::asByteArray() const {
+    if (type != TagType::TagByteArray) {
+        throw std::runtime_error("NBT tag is not a byte array: " + std::string(name));
+    }
+    return NBTArrayView<int8_t>(payload, length);
+}
+
+NBTArrayView<int32_t> NBTParser::NBTNode::asIntArray() const {
+    if (type != TagType::TagIntArray) {
+        throw std::runtime_error("NBT tag is not an int array: " + std::string(name));
+    }
+    return NBTArrayView<int32_t>(payload, length);
+}
+
+NBTArrayView<uint64_t> NBTParser::NBTNode::asLongArray() const {
+    if (type != TagType::TagLongArray) {
+        throw std::runtime_error("NBT tag is not a long array: " + std::string(name));
+    }
+    return NBTArrayView<uint64_t>(payload, length);
+}
+
+const NBTParser::NBTNode *NBTParser::parseNBT(ByteBufferView &buffer, NBTArena &arena) {
+    NBTTreeBuilder builder(arena);
+    parseNBT(buffer, builder);
+    return builder.getRoot();
+}
+
+const NBTParser::NBTNode *NBTParser::parseNBT(ByteBufferView &buffer, NBTArena &arena, const NBTPathQuery &query) {
+    NBTTreeBuilder builder(arena);
+    parseNBT(buffer, builder, query);
+    return builder.getRoot();
+}
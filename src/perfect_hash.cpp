@@ -0,0 +1,87 @@
+#include "perfect_hash.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+const size_t KEYS_PER_BUCKET = 4;
+const uint32_t MAX_SEED = 1 << 20;
+
+PerfectHash::Table PerfectHash::build(const std::vector<std::string_view> &keys)
+{
+    std::vector<std::string_view> sortedKeys(keys);
+    std::sort(sortedKeys.begin(), sortedKeys.end());
+    auto duplicate = std::adjacent_find(sortedKeys.begin(), sortedKeys.end());
+    if (duplicate != sortedKeys.end())
+    {
+        throw std::invalid_argument("Duplicate perfect hash key: " + std::string(*duplicate));
+    }
+
+    // At most 80% of the slots are used, the last buckets still find seeds quickly
+    Table table;
+    size_t nSlots = 1;
+    while (nSlots * 4 < keys.size() * 5)
+    {
+        nSlots <<= 1;
+    }
+    size_t nBuckets = std::max<size_t>(1, (keys.size() + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+    table.seeds.assign(nBuckets, 0);
+    table.slots.assign(nSlots, -1);
+
+    std::vector<uint64_t> hashes(keys.size());
+    std::vector<std::vector<int32_t>> buckets(nBuckets);
+    for (size_t keyIdx = 0; keyIdx < keys.size(); ++keyIdx)
+    {
+        hashes[keyIdx] = hashKey(keys[keyIdx]);
+        buckets[(hashes[keyIdx] >> 32) % nBuckets].push_back(static_cast<int32_t>(keyIdx));
+    }
+
+    // Place the largest buckets first, while most slots are free
+    std::vector<size_t> bucketOrder(nBuckets);
+    std::iota(bucketOrder.begin(), bucketOrder.end(), 0);
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](size_t a, size_t b)
+                     { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<uint32_t> bucketSlots;
+    for (size_t bucketIdx : bucketOrder)
+    {
+        const std::vector<int32_t> &bucket = buckets[bucketIdx];
+        if (bucket.empty())
+        {
+            break;
+        }
+
+        // Try seeds until every key of the bucket lands on a distinct free slot
+        uint32_t seed = 1;
+        for (;; ++seed)
+        {
+            if (seed > MAX_SEED)
+            {
+                throw std::runtime_error("No perfect hash found for " + std::to_string(keys.size()) + " keys");
+            }
+
+            bucketSlots.clear();
+            for (int32_t keyIdx : bucket)
+            {
+                uint32_t slot = getPerfectHashSlot(hashes[keyIdx], seed, nSlots);
+                if (table.slots[slot] != -1 || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+                {
+                    break;
+                }
+                bucketSlots.push_back(slot);
+            }
+            if (bucketSlots.size() == bucket.size())
+            {
+                break;
+            }
+        }
+
+        table.seeds[bucketIdx] = seed;
+        for (size_t i = 0; i < bucket.size(); ++i)
+        {
+            table.slots[bucketSlots[i]] = bucket[i];
+        }
+    }
+
+    return table;
+}
@@ -1,37 +1,133 @@
 #include "region.h"
 #include "config.h"
 #include <iostream>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+const int N_CHUNKS_PER_REGION = N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ;
+
+struct Region::LazyChunks
+{
+    ChunkLoader chunkLoader;
+    std::once_flag loadFlags[N_CHUNKS_PER_REGION];
+    std::atomic<bool> loaded[N_CHUNKS_PER_REGION] = {};
+};
 
 Region::Region(RegionData data, int regionXWorld, int regionZWorld)
-    : data(data), regionXWorld(regionXWorld), regionZWorld(regionZWorld)
+    : data(std::move(data)), regionXWorld(regionXWorld), regionZWorld(regionZWorld)
+{
+}
+
+Region::Region(ChunkLoader chunkLoader, int regionXWorld, int regionZWorld)
+    : data(N_CHUNKS_PER_REGION * N_SECTIONS_PER_CHUNK_Y), lazyChunks(std::make_unique<LazyChunks>()),
+      regionXWorld(regionXWorld), regionZWorld(regionZWorld)
 {
+    lazyChunks->chunkLoader = std::move(chunkLoader);
 }
 
+Region::Region(Region &&other) noexcept = default;
+
 Region::~Region()
 {
 }
 
+void Region::ensureChunkLoaded(int chunkX, int chunkZ) const
+{
+    if (!lazyChunks)
+    {
+        return;
+    }
+
+    int chunkIdx = chunkX + chunkZ * N_CHUNKS_PER_REGION_XZ;
+    if (lazyChunks->loaded[chunkIdx].load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // Concurrent first touches of a chunk wait for a single decode. Each chunk owns its own
+    // slots in data, so filling them never races with reads of other chunks.
+    std::call_once(lazyChunks->loadFlags[chunkIdx], [&]()
+                   {
+        ChunkData chunkBlocks = lazyChunks->chunkLoader(chunkX, chunkZ);
+        chunkBlocks.resize(N_SECTIONS_PER_CHUNK_Y);
+        std::move(chunkBlocks.begin(), chunkBlocks.end(), data.begin() + getSectionIndex(chunkX, 0, chunkZ));
+        lazyChunks->loaded[chunkIdx].store(true, std::memory_order_release); });
+}
+
 const RegionData &Region::getDataByRegion() const
 {
     return data;
 }
 
+bool Region::isLazy() const
+{
+    return lazyChunks != nullptr;
+}
+
+bool Region::isChunkLoaded(int chunkX, int chunkZ) const
+{
+    return !lazyChunks || lazyChunks->loaded[chunkX + chunkZ * N_CHUNKS_PER_REGION_XZ].load(std::memory_order_acquire);
+}
+
+void Region::loadChunk(int chunkX, int chunkZ) const
+{
+    ensureChunkLoaded(chunkX, chunkZ);
+}
+
+void Region::adoptChunk(const Region &source, int chunkX, int chunkZ)
+{
+    if (!lazyChunks || !source.isChunkLoaded(chunkX, chunkZ))
+    {
+        return;
+    }
+
+    int chunkIdx = chunkX + chunkZ * N_CHUNKS_PER_REGION_XZ;
+    std::call_once(lazyChunks->loadFlags[chunkIdx], [&]()
+                   {
+        int firstSectionIdx = getSectionIndex(chunkX, 0, chunkZ);
+        std::copy(source.data.begin() + firstSectionIdx, source.data.begin() + firstSectionIdx + N_SECTIONS_PER_CHUNK_Y, data.begin() + firstSectionIdx);
+        lazyChunks->loaded[chunkIdx].store(true, std::memory_order_release); });
+}
+
 const SectionData &Region::getSectionAt(int sx, int sy, int sz) const
 {
-    return data[sx][sz][sy];
+    ensureChunkLoaded(sx, sz);
+    const SectionPtr &section = data[getSectionIndex(sx, sy, sz)];
+    return section ? *section : SectionData::getMissing();
+}
+
+bool Region::isSectionMissing(int sx, int sy, int sz) const
+{
+    ensureChunkLoaded(sx, sz);
+    return !data[getSectionIndex(sx, sy, sz)];
+}
+
+bool Region::isSectionUniform(int sx, int sy, int sz) const
+{
+    return getSectionAt(sx, sy, sz).isUniform();
+}
+
+uint16_t Region::getUniformBlockId(int sx, int sy, int sz) const
+{
+    return getSectionAt(sx, sy, sz).getPalette()[0];
 }
 
 const uint16_t Region::getBlockAt(int x, int y, int z) const
 {
-    int sx = x / SECTION_SIZE;
-    int sy = y / SECTION_SIZE;
-    int sz = z / SECTION_SIZE;
-    
-    int dx = x % SECTION_SIZE;
-    int dy = y % SECTION_SIZE;
-    int dz = z % SECTION_SIZE;
+    int sx = x >> SECTION_SHIFT;
+    int sy = y >> SECTION_SHIFT;
+    int sz = z >> SECTION_SHIFT;
 
-    return this->getSectionAt(sx, sy, sz)[dx][dy][dz];
+    ensureChunkLoaded(sx, sz);
+    const SectionPtr &section = data[getSectionIndex(sx, sy, sz)];
+    if (!section)
+    {
+        return 0xFFFF;
+    }
+
+    return section->get(x & SECTION_MASK, y & SECTION_MASK, z & SECTION_MASK);
 }
 
 int Region::getRegionXWorld() const
@@ -57,4 +153,31 @@ int Region::getSizeY() const
 int Region::getSizeZ() const
 {
     return N_CHUNKS_PER_REGION_XZ * SECTION_SIZE;
-}
\ No newline at end of file
+}
+
+size_t Region::getMemoryUsage() const
+{
+    size_t memoryUsage = data.capacity() * sizeof(SectionPtr);
+    for (int chunkX = 0; chunkX < N_CHUNKS_PER_REGION_XZ; ++chunkX)
+    {
+        for (int chunkZ = 0; chunkZ < N_CHUNKS_PER_REGION_XZ; ++chunkZ)
+        {
+            // Chunks still being decoded are skipped
+            if (!isChunkLoaded(chunkX, chunkZ))
+            {
+                continue;
+            }
+
+            for (int sy = 0; sy < N_SECTIONS_PER_CHUNK_Y; ++sy)
+            {
+                const SectionPtr &section = data[getSectionIndex(chunkX, sy, chunkZ)];
+                if (section && !section->isUniform())
+                {
+                    memoryUsage += sizeof(SectionData) + section->getMemoryUsage();
+                }
+            }
+        }
+    }
+
+    return memoryUsage;
+}
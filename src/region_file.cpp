@@ -0,0 +1,230 @@
+#include "region_file.h"
+#include "config.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RegionFile::RegionFile(const std::filesystem::path &filePath, AccessPattern accessPattern)
+    : filePath(filePath), mappedData(nullptr), mappedSize(0)
+{
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+
+    // Open the region file
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to open region file: " + filePath.string());
+    }
+    fileHandle = file;
+
+    // Get file size
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to read region file size: " + filePath.string());
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+    // Map the whole file read-only, empty files cannot be mapped
+    if (mappedSize > 0)
+    {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map region file: " + filePath.string());
+        }
+        mappingHandle = mapping;
+
+        mappedData = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (mappedData == nullptr)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map region file: " + filePath.string());
+        }
+    }
+#else
+    // Open the region file
+    fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        throw std::runtime_error("Failed to open region file: " + filePath.string());
+    }
+
+    // Get file size
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0)
+    {
+        close(fileDescriptor);
+        throw std::runtime_error("Failed to read region file size: " + filePath.string());
+    }
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+
+    // Map the whole file read-only, empty files cannot be mapped
+    if (mappedSize > 0)
+    {
+        void *mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapping == MAP_FAILED)
+        {
+            close(fileDescriptor);
+            throw std::runtime_error("Failed to map region file: " + filePath.string());
+        }
+        mappedData = static_cast<const char *>(mapping);
+    }
+#endif
+
+    advise(accessPattern);
+}
+
+RegionFile::~RegionFile()
+{
+#ifdef _WIN32
+    if (mappedData)
+    {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (mappedData)
+    {
+        munmap(const_cast<char *>(mappedData), mappedSize);
+    }
+    if (fileDescriptor >= 0)
+    {
+        close(fileDescriptor);
+    }
+#endif
+}
+
+void RegionFile::advise(AccessPattern accessPattern) const
+{
+    advise(std::string_view(mappedData, mappedSize), accessPattern);
+}
+
+void RegionFile::advise(std::string_view range, AccessPattern accessPattern) const
+{
+    if (range.empty())
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // Windows only exposes an explicit prefetch, other patterns are left to the cache manager
+    if (accessPattern == AccessPattern::WillNeed)
+    {
+        WIN32_MEMORY_RANGE_ENTRY entry;
+        entry.VirtualAddress = const_cast<char *>(range.data());
+        entry.NumberOfBytes = range.size();
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+    }
+#else
+    int advice = MADV_NORMAL;
+    switch (accessPattern)
+    {
+    case AccessPattern::Normal:
+        advice = MADV_NORMAL;
+        break;
+    case AccessPattern::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case AccessPattern::Random:
+        advice = MADV_RANDOM;
+        break;
+    case AccessPattern::WillNeed:
+        advice = MADV_WILLNEED;
+        break;
+    }
+
+    // madvise needs a page aligned start address
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(range.data());
+    uintptr_t alignedStart = start & ~(pageSize - 1);
+    madvise(reinterpret_cast<void *>(alignedStart), range.size() + (start - alignedStart), advice);
+#endif
+}
+
+const char *RegionFile::data() const
+{
+    return mappedData;
+}
+
+size_t RegionFile::size() const
+{
+    return mappedSize;
+}
+
+const std::filesystem::path &RegionFile::getPath() const
+{
+    return filePath;
+}
+
+uint32_t RegionFile::getChunkLocation(int chunkIdx) const
+{
+    if (chunkIdx < 0 || chunkIdx >= N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ)
+    {
+        throw std::out_of_range("Chunk index out of range: " + std::to_string(chunkIdx));
+    }
+    if (mappedSize < SECTOR_BYTES)
+    {
+        return 0;
+    }
+
+    const unsigned char *entry = reinterpret_cast<const unsigned char *>(mappedData) + chunkIdx * 4;
+    return (static_cast<uint32_t>(entry[0]) << 24) |
+           (static_cast<uint32_t>(entry[1]) << 16) |
+           (static_cast<uint32_t>(entry[2]) << 8) |
+           (static_cast<uint32_t>(entry[3]));
+}
+
+uint32_t RegionFile::getChunkTimestamp(int chunkIdx) const
+{
+    if (chunkIdx < 0 || chunkIdx >= N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ)
+    {
+        throw std::out_of_range("Chunk index out of range: " + std::to_string(chunkIdx));
+    }
+    if (mappedSize < 2 * SECTOR_BYTES)
+    {
+        return 0;
+    }
+
+    const unsigned char *entry = reinterpret_cast<const unsigned char *>(mappedData) + SECTOR_BYTES + chunkIdx * 4;
+    return (static_cast<uint32_t>(entry[0]) << 24) |
+           (static_cast<uint32_t>(entry[1]) << 16) |
+           (static_cast<uint32_t>(entry[2]) << 8) |
+           (static_cast<uint32_t>(entry[3]));
+}
+
+std::string_view RegionFile::getChunkSectors(int chunkIdx) const
+{
+    uint32_t location = getChunkLocation(chunkIdx);
+    size_t offset = static_cast<size_t>(location >> OFFSET_SHIFT) * SECTOR_BYTES;
+    size_t sectorBytes = static_cast<size_t>(location & SECTOR_COUNT_MASK) * SECTOR_BYTES;
+
+    if (offset + sectorBytes > mappedSize)
+    {
+        throw std::out_of_range("Chunk offset is outside region data range");
+    }
+
+    return std::string_view(mappedData + offset, sectorBytes);
+}
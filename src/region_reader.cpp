@@ -1,326 +1,437 @@
 #include "region_reader.h"
 #include "nbt_parser.h"
+#include "chunk_decode_context.h"
+#include "section_unpacker.h"
+#include "thread_pool.h"
 #include "config.h"
 #include <iostream>
 #include <filesystem>
-#include <fstream>
 #include <vector>
-#include <future>
-#include <zlib/zlib.h>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <string_view>
+#include <memory>
+#include <regex>
 
 namespace fs = std::filesystem;
 
-const int ZLIB_COMPRESSION_TYPE = 2;
-const int OFFSET_SHIFT = 8;
-const int SECTOR_BYTES = 4096;
-const int SECTOR_COUNT_MASK = 0xFF;
-const int TOTAL_SECTION_BLOCKS = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
 
-std::vector<char> RegionReader::getRegionData(const std::filesystem::path &filePath)
-{
-    // Open the region file
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open())
-    {
-        throw std::runtime_error("Failed to open region file: " + filePath.string());
-    }
+const size_t N_BATCHES_PER_WORKER = 4;
 
-    // Get file size
-    file.seekg(0, std::ios::end);
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
+// Everything else in a chunk (entities, lighting, heightmaps, ...) is skipped unparsed
+const NBTParser::NBTPathQuery CHUNK_QUERY = {
+    "{xPos,zPos}",
+    "sections/*/Y",
+    "sections/*/block_states/palette/*/Name",
+    "sections/*/block_states/data"};
 
-    // Read the entire file into memory
-    std::vector<char> regionData(size);
-    if (!file.read(regionData.data(), size))
-    {
-        throw std::runtime_error("Failed to read region file: " + filePath.string());
-    }
-
-    return regionData;
-}
-
-std::vector<uint32_t> RegionReader::getChunkLocationData(const std::vector<char> &regionData)
+std::vector<uint32_t> RegionReader::getChunkLocationData(const RegionFile &regionFile)
 {
     // Read the chunk location table
-    std::vector<uint32_t> locations(SECTOR_BYTES / 4);
-    for (int i = 0; i < SECTOR_BYTES / 4; ++i)
+    std::vector<uint32_t> locations(N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ);
+    for (int i = 0; i < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++i)
     {
-        uint32_t location =
-            (static_cast<uint32_t>(static_cast<unsigned char>(regionData[i * 4])) << 24) |
-            (static_cast<uint32_t>(static_cast<unsigned char>(regionData[i * 4 + 1])) << 16) |
-            (static_cast<uint32_t>(static_cast<unsigned char>(regionData[i * 4 + 2])) << 8) |
-            (static_cast<uint32_t>(static_cast<unsigned char>(regionData[i * 4 + 3])));
-        locations[i] = location;
+        locations[i] = regionFile.getChunkLocation(i);
     }
 
     return locations;
 }
 
-std::vector<uint16_t> RegionReader::processSection(const std::vector<uint64_t> &data, int bitLength)
+void RegionReader::processSection(const NBTArrayView<uint64_t> &data, int bitLength, uint16_t *blockIndices)
 {
-    if (bitLength <= 0 || bitLength > 64)
-    {
-        throw std::invalid_argument("Invalid bit length: " + std::to_string(bitLength));
-    }
-
-    int indicesPerLong = 64 / bitLength;
-    uint64_t mask = (1ULL << bitLength) - 1;
-
-    std::vector<uint16_t> result;
-    result.reserve(TOTAL_SECTION_BLOCKS);
-
-    for (uint64_t value : data)
-    {
-        for (int i = 0; i < indicesPerLong && result.size() < TOTAL_SECTION_BLOCKS; ++i)
-        {
-            uint16_t index = (value >> (i * bitLength)) & mask;
-            result.push_back(index);
-        }
-    }
+    // Longs past the ones a full section needs are never read
+    uint64_t packedIndices[MAX_PACKED_SECTION_LONGS];
+    size_t packedLength = std::min<size_t>(data.size(), MAX_PACKED_SECTION_LONGS);
+    data.copyTo(packedIndices, packedLength);
 
-    return result;
+    unpackSectionIndices(packedIndices, packedLength, bitLength, blockIndices);
 }
 
-ByteBuffer RegionReader::getChunkDataStream(const std::vector<uint32_t> &locations, int chunkIdx, const std::vector<char> &regionData)
+ByteBufferView RegionReader::getChunkDataStream(const RegionFile &regionFile, int chunkIdx)
 {
-    uint32_t offset = (locations[chunkIdx] >> OFFSET_SHIFT) * SECTOR_BYTES;
-    uint32_t sectorCount = (locations[chunkIdx] & SECTOR_COUNT_MASK) * SECTOR_BYTES;
-
-    if (offset + sectorCount > regionData.size())
-    {
-        throw std::out_of_range("Chunk offset is outside region data range");
-    }
-
-    std::vector<char> chunkData(regionData.begin() + offset, regionData.begin() + offset + sectorCount);
-    return ByteBuffer(std::move(chunkData));
+    // View the chunk sectors directly in the mapping
+    return ByteBufferView(regionFile.getChunkSectors(chunkIdx));
 }
 
-std::tuple<int, int, int, int, ChunkData> RegionReader::readAndProcessChunk(const ByteBuffer &chunkDataStream, const std::unordered_map<std::string, uint16_t> &blockIdDict)
+std::tuple<int, int, int, int, ChunkData> RegionReader::readAndProcessChunk(const ByteBufferView &chunkDataStream, BlockIdResolver &blockIdResolver)
 {
-    ByteBuffer buffer(chunkDataStream.data());
+    ChunkDecodeContext &context = ChunkDecodeContext::forCurrentThread();
+    context.beginChunk();
+    auto stageStart = context.beginStage();
+
+    ByteBufferView buffer = chunkDataStream;
     buffer.seek(0);
 
     // Read the chunk header
     uint32_t chunkDataLength = buffer.read<uint32_t>();
     uint8_t compressionType = buffer.read<uint8_t>();
 
-    // Invalid chunk or unsupported compression type
-    if (chunkDataLength <= 0 || compressionType != ZLIB_COMPRESSION_TYPE)
+    // Invalid chunk
+    if (chunkDataLength <= 1)
     {
-        throw std::runtime_error("Invalid chunk or unsupported compression type");
+        throw std::runtime_error("Invalid chunk data length");
     }
+    ByteBufferView compressedData = buffer.readView(chunkDataLength - 1); // -1 to exclude the compression type byte
 
-    // Read and decompress the chunk data
-    std::vector<char> compressedData = buffer.read(chunkDataLength - 1); // -1 to exclude the compression type byte
-    z_stream zstream;
-    std::memset(&zstream, 0, sizeof(zstream));
-    if (inflateInit(&zstream) != Z_OK)
+    // Fault the mapped bytes in now when timing stages, they would count as inflate time otherwise
+    if (ChunkDecodeContext::isStageTiming())
     {
-        throw std::runtime_error("Failed to initialize zlib inflation");
-    }
-
-    zstream.next_in = reinterpret_cast<Bytef *>(compressedData.data());
-    zstream.avail_in = compressedData.size();
-
-    std::vector<char> decompressedData;
-    char outBuffer[4096];
-
-    do
-    {
-        zstream.next_out = reinterpret_cast<Bytef *>(outBuffer);
-        zstream.avail_out = sizeof(outBuffer);
-
-        int ret = inflate(&zstream, Z_NO_FLUSH);
-
-        if (ret != Z_OK && ret != Z_STREAM_END)
+        volatile char touched = 0;
+        for (size_t offset = 0; offset < compressedData.size(); offset += SECTOR_BYTES)
         {
-            inflateEnd(&zstream);
-            throw std::runtime_error("Failed to decompress chunk data");
+            touched = touched + compressedData.bytes()[offset];
         }
+    }
+    context.endStage(DecodeStage::Read, stageStart, compressedData.size());
 
-        decompressedData.insert(decompressedData.end(), outBuffer, outBuffer + (sizeof(outBuffer) - zstream.avail_out));
-    } while (zstream.avail_out == 0);
-
-    inflateEnd(&zstream);
+    // Decompress the chunk data with this worker's reusable buffers, unsupported compression types throw
+    stageStart = context.beginStage();
+    ByteBufferView decompressedBuffer = context.decompress(compressionType, compressedData);
+    context.endStage(DecodeStage::Inflate, stageStart, decompressedBuffer.size());
 
-    // Parse the decompressed data
-    ByteBuffer decompressedBuffer(decompressedData);
-    NBTParser::NBTTag root = NBTParser::parseNBT(decompressedBuffer);
+    // Parse the fields needed below into a tree in the worker's arena. The tree is built from the
+    // streaming visitor's events and only holds CHUNK_QUERY's tags, so it costs a few microseconds
+    // per chunk over collecting them in a visitor, but needs no per-section collection state and
+    // does not depend on the order of a section's keys
+    stageStart = context.beginStage();
+    const NBTParser::NBTNode *root = context.parse(decompressedBuffer, CHUNK_QUERY);
+    context.endStage(DecodeStage::Parse, stageStart, decompressedBuffer.size());
 
-    // Initialize empty data
-    ChunkData chunkBlocks(
-        N_SECTIONS_PER_CHUNK_Y,
-        SectionData(
-            SECTION_SIZE,
-            SectionPlaneData(
-                SECTION_SIZE,
-                SectionLineData(SECTION_SIZE, 0xFFFF) // 0xFFFF for missing sections
-                )));
+    // Initialize empty data, sections start out missing (null)
+    ChunkData chunkBlocks(N_SECTIONS_PER_CHUNK_Y);
 
     // Process the chunk data
-    int chunkXInWorld = root.compoundValue["xPos"].intValue;
-    int chunkZInWorld = root.compoundValue["zPos"].intValue;
-    int chunkXInRegion = chunkXInWorld % N_CHUNKS_PER_REGION_XZ;
-    int chunkZInRegion = chunkZInWorld % N_CHUNKS_PER_REGION_XZ;
-
-    NBTParser::NBTTag sections = root.compoundValue["sections"];
-    for (NBTParser::NBTTag sectionEntry : sections.listValue)
+    const NBTParser::NBTNode *xPos = root->get("xPos");
+    const NBTParser::NBTNode *zPos = root->get("zPos");
+    if (!xPos || !zPos)
     {
-        NBTParser::NBTTag sectionBlockStates = sectionEntry.compoundValue["block_states"];
+        throw std::runtime_error("Chunk is missing its position");
+    }
+    int chunkXInWorld = xPos->asInt();
+    int chunkZInWorld = zPos->asInt();
+    int chunkXInRegion = chunkXInWorld & REGION_MASK;
+    int chunkZInRegion = chunkZInWorld & REGION_MASK;
 
+    const NBTParser::NBTNode *sections = root->get("sections");
+    if (!sections)
+    {
+        return {chunkXInRegion, chunkZInRegion, chunkXInWorld, chunkZInWorld, std::move(chunkBlocks)};
+    }
+    for (const NBTParser::NBTNode &sectionEntry : *sections)
+    {
         // Get the section Y value and index
-        NBTParser::NBTTag sectionY = sectionEntry.compoundValue["Y"];
-        int sectionYValue = static_cast<int8_t>(sectionY.intValue);
+        const NBTParser::NBTNode *sectionY = sectionEntry.get("Y");
+        const NBTParser::NBTNode *sectionBlockStates = sectionEntry.get("block_states");
+        if (!sectionY || !sectionBlockStates)
+        {
+            continue;
+        }
+        int sectionYValue = static_cast<int8_t>(sectionY->asInt());
         int sectionYIndex = sectionYValue - (MIN_Y / SECTION_SIZE);
+        if (sectionYIndex < 0 || sectionYIndex >= N_SECTIONS_PER_CHUNK_Y)
+        {
+            continue;
+        }
 
-        // Get the palette data
-        std::vector<std::string> palette;
-        NBTParser::NBTTag sectionPalette = sectionBlockStates.compoundValue["palette"];
-        if (sectionPalette.type != NBTParser::TagType::TagList)
+        // Resolve the palette to block IDs once, entries without a name keep their slot
+        const NBTParser::NBTNode *sectionPalette = sectionBlockStates->get("palette");
+        if (!sectionPalette || sectionPalette->type != NBTParser::TagType::TagList || sectionPalette->size() == 0)
         {
             continue;
         }
-        for (NBTParser::NBTTag paletteEntry : sectionPalette.listValue)
+        stageStart = context.beginStage();
+        size_t paletteNameBytes = 0;
+        std::vector<uint16_t> paletteIds;
+        paletteIds.reserve(sectionPalette->size());
+        for (const NBTParser::NBTNode &paletteEntry : *sectionPalette)
         {
-            if (paletteEntry.type != NBTParser::TagType::TagCompound)
+            const NBTParser::NBTNode *blockName = paletteEntry.get("Name");
+            if (!blockName || blockName->type != NBTParser::TagType::TagString)
             {
+                paletteIds.push_back(blockIdResolver.getFallbackId());
                 continue;
             }
-            for (auto &entry : paletteEntry.compoundValue)
-            {
-                if (entry.first != "Name" || entry.second.type != NBTParser::TagType::TagString)
-                {
-                    continue;
-                }
-                std::string blockName = entry.second.stringValue;
-                blockName = blockName.substr(10);
-                palette.push_back(blockName);
-            }
+            std::string_view name = blockName->asString();
+            paletteNameBytes += name.size();
+            paletteIds.push_back(blockIdResolver.resolve(name.substr(std::min<size_t>(10, name.size()))));
         }
+        context.endStage(DecodeStage::Palette, stageStart, paletteNameBytes);
 
-        // Get the data
-        NBTParser::NBTTag sectionData = sectionBlockStates.compoundValue["data"];
-
-        // By default, all blocks are the same: the first block in the palette
-        std::vector<uint16_t> flatSectionBlockIndices(TOTAL_SECTION_BLOCKS, 0x0000);
-        if (sectionData.type == NBTParser::TagType::TagLongArray)
+        // Single-entry palettes carry no data: the section is uniform and is never expanded
+        const NBTParser::NBTNode *sectionData = sectionBlockStates->get("data");
+        bool hasData = sectionData && sectionData->type == NBTParser::TagType::TagLongArray && !sectionData->asLongArray().empty();
+        if (paletteIds.size() == 1 || !hasData)
         {
-            int bit_length = std::max(4, int(ceil(log2(palette.size()))));
-            flatSectionBlockIndices = processSection(sectionData.longArrayValue, bit_length);
+            stageStart = context.beginStage();
+            chunkBlocks[sectionYIndex] = SectionData::getUniform(paletteIds[0]);
+            context.endStage(DecodeStage::Store, stageStart, 0);
+            continue;
         }
 
-        // Convert block indices to block IDs
-        int i = 0;
-        for (int blockIdx : flatSectionBlockIndices)
-        {
-            // Get block coordinates within the section
-            int sx = i % SECTION_SIZE;
-            int sz = (i / SECTION_SIZE) % SECTION_SIZE;
-            int sy = i / (SECTION_SIZE * SECTION_SIZE);
+        // Unpack the block indices
+        stageStart = context.beginStage();
+        uint16_t flatSectionBlockIndices[TOTAL_SECTION_BLOCKS];
+        int bit_length = std::max(4, int(ceil(log2(paletteIds.size()))));
+        processSection(sectionData->asLongArray(), bit_length, flatSectionBlockIndices);
+        context.endStage(DecodeStage::Unpack, stageStart, sectionData->asLongArray().size() * sizeof(uint64_t));
+
+        // Repack with the block IDs actually used, indices are already in section block order.
+        // Sections that turn out to use a single ID share the uniform instance.
+        stageStart = context.beginStage();
+        SectionPtr section = std::make_shared<const SectionData>(paletteIds, flatSectionBlockIndices);
+        chunkBlocks[sectionYIndex] = section->isUniform() ? SectionData::getUniform(section->get(0, 0, 0)) : section;
+        context.endStage(DecodeStage::Store, stageStart, sizeof(flatSectionBlockIndices));
+    }
+
+    return {chunkXInRegion, chunkZInRegion, chunkXInWorld, chunkZInWorld, std::move(chunkBlocks)};
+}
 
-            const std::string &blockName = palette[blockIdx];
-            auto it = blockIdDict.find(blockName);
+ChunkData RegionReader::loadChunk(
+    const RegionFile &regionFile,
+    const std::vector<uint32_t> &chunkLocationData,
+    BlockIdResolver &blockIdResolver,
+    SectionDiskCache *sectionDiskCache,
+    int chunkX,
+    int chunkZ)
+{
+    // Chunks that were never generated have no location
+    int chunkIdx = chunkX + chunkZ * N_CHUNKS_PER_REGION_XZ;
+    if (chunkLocationData[chunkIdx] == 0)
+    {
+        return ChunkData(N_SECTIONS_PER_CHUNK_Y);
+    }
 
-            if (it != blockIdDict.end())
-            {
-                chunkBlocks[sectionYIndex][sx][sy][sz] = it->second;
-            }
-            else
-            {
-                std::cerr << "Unknown block found: " << blockName << std::endl;
-            }
-            i += 1;
-        }
+    // Chunks unchanged since they were cached skip decoding
+    uint32_t timestamp = regionFile.getChunkTimestamp(chunkIdx);
+    ChunkData chunkBlocks;
+    if (sectionDiskCache && sectionDiskCache->readChunk(chunkIdx, timestamp, chunkLocationData[chunkIdx], chunkBlocks))
+    {
+        return chunkBlocks;
     }
 
-    return {chunkXInRegion, chunkZInRegion, chunkXInWorld, chunkZInWorld, chunkBlocks};
+    // A chunk that fails to decode stays missing rather than failing the access
+    try
+    {
+        ByteBufferView chunkDataStream = getChunkDataStream(regionFile, chunkIdx);
+        chunkBlocks = std::get<4>(readAndProcessChunk(chunkDataStream, blockIdResolver));
+        if (sectionDiskCache)
+        {
+            sectionDiskCache->storeChunk(chunkIdx, timestamp, chunkLocationData[chunkIdx], chunkBlocks);
+        }
+        return chunkBlocks;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error processing chunk: " << e.what() << std::endl;
+        return ChunkData(N_SECTIONS_PER_CHUNK_Y);
+    }
 }
 
 std::tuple<int, int> RegionReader::processChunks(
     const std::vector<uint32_t> &chunkLocationData,
-    const std::vector<char> &regionData,
-    const std::unordered_map<std::string, uint16_t> &blockIdDict,
+    const RegionFile &regionFile,
+    BlockIdResolver &blockIdResolver,
     RegionData &data)
 {
-    // Process chunks in parallel
+    // Process chunks in parallel on the shared pool, so each worker's decode context is reused
     std::cout << "Processing chunks..." << std::endl;
-    std::vector<std::future<std::tuple<int, int, int, int, ChunkData>>> futures;
+
+    std::vector<int> chunkIndices;
     for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
     {
-        if (chunkLocationData[chunkIdx] == 0)
+        if (chunkLocationData[chunkIdx] != 0)
         {
-            continue;
+            chunkIndices.push_back(chunkIdx);
         }
+    }
 
-        futures.emplace_back(
-            std::async(
-                std::launch::async, [&, chunkIdx]()
-                { 
-                    ByteBuffer chunkDataStream = getChunkDataStream(chunkLocationData, chunkIdx, regionData);
-                    return readAndProcessChunk(chunkDataStream, blockIdDict); }));
+    // Hand chunks to the shared pool in batches, a few per worker to balance uneven chunks
+    ThreadPool &threadPool = ThreadPool::getShared();
+    size_t batchSize = std::max<size_t>(1, chunkIndices.size() / (threadPool.getThreadCount() * N_BATCHES_PER_WORKER));
+
+    // Decoded chunks are queued as they complete, errors travel with them
+    struct ChunkResult
+    {
+        std::tuple<int, int, int, int, ChunkData> chunk;
+        std::exception_ptr error;
+    };
+    std::vector<ChunkResult> completedChunks;
+    std::mutex completedMutex;
+    std::condition_variable completedCondition;
+
+    for (size_t batchStart = 0; batchStart < chunkIndices.size(); batchStart += batchSize)
+    {
+        size_t batchEnd = std::min(batchStart + batchSize, chunkIndices.size());
+        threadPool.submit([&, batchStart, batchEnd]()
+                          {
+            for (size_t next = batchStart; next < batchEnd; ++next)
+            {
+                ChunkResult result;
+                try
+                {
+                    ByteBufferView chunkDataStream = getChunkDataStream(regionFile, chunkIndices[next]);
+                    result.chunk = readAndProcessChunk(chunkDataStream, blockIdResolver);
+                }
+                catch (...)
+                {
+                    result.error = std::current_exception();
+                }
+
+                // Notify under the lock, the waiting thread may return as soon as it sees the last chunk
+                std::lock_guard<std::mutex> lock(completedMutex);
+                completedChunks.push_back(std::move(result));
+                completedCondition.notify_one();
+            } });
     }
 
     int regionXWorld = std::numeric_limits<int>::min();
     int regionZWorld = std::numeric_limits<int>::min();
-    for (auto &future : futures)
+    std::vector<ChunkResult> results;
+    for (size_t nConsumed = 0; nConsumed < chunkIndices.size(); nConsumed += results.size())
     {
-        try
+        // Take every chunk completed so far
+        results.clear();
+        {
+            std::unique_lock<std::mutex> lock(completedMutex);
+            completedCondition.wait(lock, [&]()
+                                    { return !completedChunks.empty(); });
+            std::swap(results, completedChunks);
+        }
+
+        for (ChunkResult &result : results)
         {
-            auto result = future.get();
-            auto [chunkXRegion, chunkZRegion, chunkXWorld, chunkZWorld, chunkBlocks] = result;
+            try
+            {
+                if (result.error)
+                {
+                    std::rethrow_exception(result.error);
+                }
+                auto &[chunkXRegion, chunkZRegion, chunkXWorld, chunkZWorld, chunkBlocks] = result.chunk;
 
-            // Set the chunk data
-            data[chunkXRegion][chunkZRegion] = std::move(chunkBlocks);
+                // Set the chunk data, a chunk's sections are contiguous in the region
+                int firstSectionIdx = Region::getSectionIndex(chunkXRegion, 0, chunkZRegion);
+                std::move(chunkBlocks.begin(), chunkBlocks.end(), data.begin() + firstSectionIdx);
 
-            if (regionXWorld == std::numeric_limits<int>::min() || regionZWorld == std::numeric_limits<int>::min())
+                if (regionXWorld == std::numeric_limits<int>::min() || regionZWorld == std::numeric_limits<int>::min())
+                {
+                    regionXWorld = chunkXWorld >> REGION_SHIFT;
+                    regionZWorld = chunkZWorld >> REGION_SHIFT;
+                }
+            }
+            catch (const std::exception &e)
             {
-                regionXWorld = chunkXWorld / N_CHUNKS_PER_REGION_XZ;
-                regionZWorld = chunkZWorld / N_CHUNKS_PER_REGION_XZ;
+                std::cerr << "Error processing chunk: " << e.what() << std::endl;
             }
         }
-        catch (const std::exception &e)
-        {
-            std::cerr << "Error processing chunk: " << e.what() << std::endl;
-        }
     }
     std::cout << "Chunk processing complete!" << std::endl;
+    blockIdResolver.reportUnknownBlocks(std::cerr);
 
     return {regionXWorld, regionZWorld};
 }
 
 Region RegionReader::getRegion(
     const std::filesystem::path &filePath,
-    const std::unordered_map<std::string, uint16_t> &blockIdDict)
+    const std::unordered_map<std::string, uint16_t> &blockIdDict,
+    uint16_t unknownBlockId)
+{
+    // Blocks missing from the dictionary get the fallback ID and are reported once processing is done
+    BlockIdResolver blockIdResolver(blockIdDict, unknownBlockId);
+    return getRegion(filePath, blockIdResolver);
+}
+
+Region RegionReader::getRegion(const std::filesystem::path &filePath, BlockIdResolver &blockIdResolver)
 {
-    // Initialize empty data
-    RegionData data(
-        N_CHUNKS_PER_REGION_XZ,
-        ChunkLineData(
-            N_CHUNKS_PER_REGION_XZ,
-            ChunkData(
-                CHUNK_SIZE_Y / SECTION_SIZE,
-                SectionData(
-                    SECTION_SIZE,
-                    SectionPlaneData(
-                        SECTION_SIZE,
-                        SectionLineData(SECTION_SIZE, 0xFFFF) // 0xFFFF for missing sections
-                        )))));
-
-    // Get region data into memory
-    std::vector<char> regionData = getRegionData(filePath);
+    // Initialize empty data, sections start out missing (null) and cost only their pointer
+    RegionData data(N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ * N_SECTIONS_PER_CHUNK_Y);
+
+    // Map the region file, chunks are read front to back
+    RegionFile regionFile(filePath, RegionFile::AccessPattern::Sequential);
 
     // Read the chunk location table
-    std::vector<uint32_t> chunkLocationData = getChunkLocationData(regionData);
+    std::vector<uint32_t> chunkLocationData = getChunkLocationData(regionFile);
 
     // Process chunks in parallel
     int regionXWorld;
     int regionZWorld;
-    std::tie(regionXWorld, regionZWorld) = processChunks(chunkLocationData, regionData, blockIdDict, data);
+    std::tie(regionXWorld, regionZWorld) = processChunks(chunkLocationData, regionFile, blockIdResolver, data);
 
     std::cout << "Region X: " << regionXWorld << std::endl;
     std::cout << "Region Z: " << regionZWorld << std::endl;
 
     Region region = Region(std::move(data), regionXWorld, regionZWorld);
     return region;
-}
\ No newline at end of file
+}
+
+Region RegionReader::getLazyRegion(
+    const std::filesystem::path &filePath,
+    const std::unordered_map<std::string, uint16_t> &blockIdDict,
+    uint16_t unknownBlockId)
+{
+    return getLazyRegion(filePath, std::make_shared<BlockIdResolver>(blockIdDict, unknownBlockId));
+}
+
+Region RegionReader::getLazyRegion(
+    const std::filesystem::path &filePath,
+    std::shared_ptr<BlockIdResolver> blockIdResolver,
+    std::shared_ptr<SectionDiskCache> sectionDiskCache)
+{
+    // Map the region file, chunks are read in whatever order they are first accessed
+    auto regionFile = std::make_shared<RegionFile>(filePath, RegionFile::AccessPattern::Random);
+
+    // Read the chunk location table
+    auto chunkLocationData = std::make_shared<std::vector<uint32_t>>(getChunkLocationData(*regionFile));
+
+    // The region position comes from the file name, or else from the first chunk that decodes
+    int regionXWorld = 0;
+    int regionZWorld = 0;
+    bool hasRegionName = parseRegionFileName(filePath, regionXWorld, regionZWorld);
+    for (int chunkIdx = 0; !hasRegionName && chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+    {
+        if ((*chunkLocationData)[chunkIdx] == 0)
+        {
+            continue;
+        }
+
+        try
+        {
+            ByteBufferView chunkDataStream = getChunkDataStream(*regionFile, chunkIdx);
+            auto [chunkXRegion, chunkZRegion, chunkXWorld, chunkZWorld, chunkBlocks] = readAndProcessChunk(chunkDataStream, *blockIdResolver);
+            regionXWorld = chunkXWorld >> REGION_SHIFT;
+            regionZWorld = chunkZWorld >> REGION_SHIFT;
+            break;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error processing chunk: " << e.what() << std::endl;
+        }
+    }
+
+    // The loader keeps the mapping, the resolver and the cache alive as long as the region
+    Region::ChunkLoader chunkLoader = [regionFile, chunkLocationData, blockIdResolver, sectionDiskCache](int chunkX, int chunkZ)
+    {
+        return loadChunk(*regionFile, *chunkLocationData, *blockIdResolver, sectionDiskCache.get(), chunkX, chunkZ);
+    };
+    return Region(std::move(chunkLoader), regionXWorld, regionZWorld);
+}
+
+bool RegionReader::parseRegionFileName(const std::filesystem::path &filePath, int &regionX, int &regionZ)
+{
+    // Coordinates are bounded so they always fit an int
+    static const std::regex regionFileNamePattern(R"(r\.(-?\d{1,7})\.(-?\d{1,7})\.mca)");
+
+    std::smatch match;
+    std::string fileName = filePath.filename().string();
+    if (!std::regex_match(fileName, match, regionFileNamePattern))
+    {
+        return false;
+    }
+
+    regionX = std::stoi(match[1].str());
+    regionZ = std::stoi(match[2].str());
+    return true;
+}
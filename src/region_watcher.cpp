@@ -0,0 +1,156 @@
+#include "region_watcher.h"
+#include "region_reader.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <system_error>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+const int INOTIFY_QUIET_MS = 250;
+const std::chrono::milliseconds MAX_REPORT_DELAY(2000);
+
+RegionWatcher::RegionWatcher(const std::filesystem::path &regionDirectory, ChangeCallback onChange, std::chrono::milliseconds pollInterval)
+    : regionDirectory(regionDirectory), onChange(std::move(onChange)), pollInterval(pollInterval), inotifyDescriptor(-1), stopWatching(false)
+{
+#ifdef __linux__
+    // Fall back to polling when inotify is out of instances or watches
+    inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyDescriptor >= 0 && inotify_add_watch(inotifyDescriptor, regionDirectory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        close(inotifyDescriptor);
+        inotifyDescriptor = -1;
+    }
+    if (inotifyDescriptor >= 0)
+    {
+        watchThread = std::thread(&RegionWatcher::watchInotify, this);
+        return;
+    }
+    std::cerr << "inotify unavailable, polling " << regionDirectory.string() << std::endl;
+#endif
+
+    watchThread = std::thread(&RegionWatcher::watchPolling, this);
+}
+
+RegionWatcher::~RegionWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopWatching = true;
+    }
+    stopCondition.notify_all();
+    watchThread.join();
+
+#ifdef __linux__
+    if (inotifyDescriptor >= 0)
+    {
+        close(inotifyDescriptor);
+    }
+#endif
+}
+
+bool RegionWatcher::isUsingInotify() const
+{
+    return inotifyDescriptor >= 0;
+}
+
+void RegionWatcher::watchInotify()
+{
+#ifdef __linux__
+    std::set<std::filesystem::path> changedPaths;
+    auto firstChangeTime = std::chrono::steady_clock::now();
+    alignas(struct inotify_event) char buffer[16 * 1024];
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            if (stopWatching)
+            {
+                return;
+            }
+        }
+
+        // Collect events until the directory has been quiet for a moment
+        pollfd descriptor = {inotifyDescriptor, POLLIN, 0};
+        bool hasEvents = poll(&descriptor, 1, INOTIFY_QUIET_MS) > 0;
+        ssize_t length = hasEvents ? read(inotifyDescriptor, buffer, sizeof(buffer)) : 0;
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            int regionX;
+            int regionZ;
+            if (event->len > 0 && RegionReader::parseRegionFileName(event->name, regionX, regionZ))
+            {
+                if (changedPaths.empty())
+                {
+                    firstChangeTime = std::chrono::steady_clock::now();
+                }
+                changedPaths.insert(regionDirectory / event->name);
+            }
+        }
+
+        // Report when quiet, or anyway after a while under continuous writes
+        bool isQuiet = length <= 0;
+        if (!changedPaths.empty() && (isQuiet || std::chrono::steady_clock::now() - firstChangeTime > MAX_REPORT_DELAY))
+        {
+            for (const std::filesystem::path &regionPath : changedPaths)
+            {
+                onChange(regionPath);
+            }
+            changedPaths.clear();
+        }
+    }
+#endif
+}
+
+void RegionWatcher::watchPolling()
+{
+    auto scan = [this]()
+    {
+        std::map<std::filesystem::path, std::filesystem::file_time_type> writeTimes;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(regionDirectory, error))
+        {
+            int regionX;
+            int regionZ;
+            if (RegionReader::parseRegionFileName(entry.path(), regionX, regionZ))
+            {
+                writeTimes[entry.path()] = entry.last_write_time(error);
+            }
+        }
+        return writeTimes;
+    };
+
+    std::map<std::filesystem::path, std::filesystem::file_time_type> lastWriteTimes = scan();
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(stopMutex);
+            if (stopCondition.wait_for(lock, pollInterval, [this]()
+                                       { return stopWatching; }))
+            {
+                return;
+            }
+        }
+
+        // Files written since the last scan, including new ones
+        std::map<std::filesystem::path, std::filesystem::file_time_type> writeTimes = scan();
+        for (const auto &[regionPath, writeTime] : writeTimes)
+        {
+            auto it = lastWriteTimes.find(regionPath);
+            if (it == lastWriteTimes.end() || it->second != writeTime)
+            {
+                onChange(regionPath);
+            }
+        }
+        lastWriteTimes = std::move(writeTimes);
+    }
+}
@@ -3,6 +3,7 @@
 const float initialMoveSpeed = 5.0f;
 const float initialMoveSpeedIncreaseFactor = 5.0f;
 const float initialMouseSensitivity = 0.1f;
+const float velocitySmoothing = 0.2f;
 
 InputHandler::InputHandler(
     Camera &camera,
@@ -14,7 +15,8 @@ InputHandler::InputHandler(
       moveSpeed(initialMoveSpeed),
       moveSpeedIncreaseFactor(initialMoveSpeedIncreaseFactor),
       mouseSensitivity(initialMouseSensitivity),
-      developerKeyPressed(false)
+      developerKeyPressed(false),
+      velocity(0.0f, 0.0f, 0.0f)
 {
 }
 
@@ -22,11 +24,25 @@ InputHandler::~InputHandler() {}
 
 void InputHandler::handleInput(Window &window, float deltaTime)
 {
+    glm::vec3 previousPosition = camera.position;
     processKeyboard(window, deltaTime);
+
+    // Smooth the velocity over a few frames, frame times are noisy
+    if (deltaTime > 0.0f)
+    {
+        glm::vec3 frameVelocity = (camera.position - previousPosition) / deltaTime;
+        velocity = glm::mix(velocity, frameVelocity, velocitySmoothing);
+    }
+
     processMouse(window, camera.yaw, camera.pitch);
     camera.updateCameraVectors();
 }
 
+glm::vec3 InputHandler::getVelocity() const
+{
+    return velocity;
+}
+
 void InputHandler::processKeyboard(Window &window, float deltaTime)
 {
     // Speed increase
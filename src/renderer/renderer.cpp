@@ -1,6 +1,6 @@
 #include "renderer/renderer.h"
 #include "window.h"
-#include "region.h"
+#include "world.h"
 #include "config.h"
 #include <iostream>
 #include <thread>
@@ -35,7 +35,7 @@ Renderer::Renderer(const std::unordered_map<uint16_t, glm::vec3> &blockColorDict
       pendingSectionViewDistance(32),
       isRunning(true),
       lastFrameTime(0.0f),
-      region(nullptr),
+      world(nullptr),
       camera(),
       inputHandler(camera, isRunning, developerModeActive),
       shaderSetup(),
@@ -62,6 +62,12 @@ Renderer::Renderer(const std::unordered_map<uint16_t, glm::vec3> &blockColorDict
 
 Renderer::~Renderer()
 {
+    // Stop change notifications before the threads they wake up
+    if (world)
+    {
+        world->stopWatching();
+    }
+
     // Signal threads to stop
     stopThreads = true;
     condition.notify_all();
@@ -197,90 +203,30 @@ void Renderer::drawCurrentSectionBounds(const glm::mat4 &viewMatrix, const glm::
 
 void Renderer::processSection(int sx, int sy, int sz, const std::string &sectionKey)
 {
-    std::unordered_map<uint16_t, std::vector<BlockFace>> blockFaces;
-
-    auto isRenderableBlock = [this](uint16_t blockId) -> bool
-    {
-        if (blockId == 0xFFFF)
-        {
-            return false;
-        }
-
-        if (std::find(noRenderBlockIds.begin(), noRenderBlockIds.end(), blockId) != noRenderBlockIds.end())
-        {
-            return false;
-        }
-
-        return true;
-    };
-
-    auto blockExists = [this, isRenderableBlock](int x, int y, int z) -> bool
-    {
-        bool outOfBounds = x < 0 || y < 0 || z < 0 || x >= region->getSizeX() || y >= region->getSizeY() || z >= region->getSizeZ();
-        if (outOfBounds)
-        {
-            return false;
-        }
-
-        return isRenderableBlock(region->getBlockAt(x, y, z));
-    };
-
-    int sectionStartX = sx * 16;
-    int sectionStartY = sy * 16;
-    int sectionStartZ = sz * 16;
-    int sectionEndX = std::min((sx + 1) * 16, region->getSizeX());
-    int sectionEndY = std::min((sy + 1) * 16, region->getSizeY());
-    int sectionEndZ = std::min((sz + 1) * 16, region->getSizeZ());
-
-    for (int x = sectionStartX; x < sectionEndX; x++)
+    // Blocks changing from here on need another pass
+    uint64_t version;
     {
-        for (int y = sectionStartY; y < sectionEndY; y++)
-        {
-            for (int z = sectionStartZ; z < sectionEndZ; z++)
-            {
-                const uint16_t blockId = region->getBlockAt(x, y, z);
-
-                // Skip non-renderable blocks
-                if (!isRenderableBlock(blockId))
-                {
-                    continue;
-                }
-
-                // Check if block is visible and skip non-visible blocks
-                if (!blockExists(x + 1, y, z))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 0});
-                }
-                if (!blockExists(x - 1, y, z))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 1});
-                }
-                if (!blockExists(x, y + 1, z))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 2});
-                }
-                if (!blockExists(x, y - 1, z))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 3});
-                }
-                if (!blockExists(x, y, z + 1))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 4});
-                }
-                if (!blockExists(x, y, z - 1))
-                {
-                    blockFaces[blockId].push_back({glm::vec3(x, y, z), 5});
-                }
-            }
-        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        version = sectionCache[sectionKey].version;
     }
 
+    auto blockFaces = std::make_shared<const std::unordered_map<uint16_t, std::vector<BlockFace>>>(sectionMesher->getSectionFaces(sx, sy, sz));
+
     // Update section cache under lock
+    bool changed;
     {
         std::lock_guard<std::mutex> lock(cacheMutex);
         sectionCache[sectionKey].blockFaces = std::move(blockFaces);
         sectionCache[sectionKey].dirty = false;
         sectionCache[sectionKey].processing = false;
+        sectionCache[sectionKey].meshedVersion = version;
+        changed = sectionCache[sectionKey].version != version;
+    }
+
+    // Blocks changed while processing
+    if (changed)
+    {
+        queueSectionForProcessing(sx, sy, sz, sectionKey);
     }
 }
 
@@ -324,9 +270,9 @@ void Renderer::renderAllSections(
     }
 }
 
-void Renderer::drawRegion(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int sectionViewDistance)
+void Renderer::drawWorld(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix, int sectionViewDistance)
 {
-    if (!region)
+    if (!world)
     {
         return;
     }
@@ -343,15 +289,26 @@ void Renderer::drawRegion(const glm::mat4 &viewMatrix, const glm::mat4 &projecti
     {
         lastCameraSectionPos = currentSectionPos;
         triggerSectionDiscoveryUpdate(currentSectionPos, sectionViewDistance);
+
+        // Stream regions around the camera, this never waits for them to load
+        world->updateFocus(camera.position.x, camera.position.z, (sectionViewDistance + 1) * SECTION_SIZE);
+
+        // Decode the chunks ahead of the camera before it reaches them
+        glm::vec3 velocity = inputHandler.getVelocity();
+        chunkPrefetcher->update(camera.position.x, camera.position.z, velocity.x, velocity.z, sectionViewDistance * SECTION_SIZE);
     }
 
     // Calculate visible section range
-    int startX = std::max(0, std::min(region->getSizeX() / SECTION_SIZE, currentSectionPos.x - sectionViewDistance));
-    int startY = std::max(0, std::min(region->getSizeY() / SECTION_SIZE, currentSectionPos.y - sectionViewDistance));
-    int startZ = std::max(0, std::min(region->getSizeZ() / SECTION_SIZE, currentSectionPos.z - sectionViewDistance));
-    int endX = std::max(0, std::min(region->getSizeX() / SECTION_SIZE, currentSectionPos.x + sectionViewDistance + 1));
-    int endY = std::max(0, std::min(region->getSizeY() / SECTION_SIZE, currentSectionPos.y + sectionViewDistance + 1));
-    int endZ = std::max(0, std::min(region->getSizeZ() / SECTION_SIZE, currentSectionPos.z + sectionViewDistance + 1));
+    int minSectionX = world->getMinX() / SECTION_SIZE;
+    int minSectionZ = world->getMinZ() / SECTION_SIZE;
+    int maxSectionX = world->getMaxX() / SECTION_SIZE;
+    int maxSectionZ = world->getMaxZ() / SECTION_SIZE;
+    int startX = std::max(minSectionX, std::min(maxSectionX, currentSectionPos.x - sectionViewDistance));
+    int startY = std::max(0, std::min(world->getSizeY() / SECTION_SIZE, currentSectionPos.y - sectionViewDistance));
+    int startZ = std::max(minSectionZ, std::min(maxSectionZ, currentSectionPos.z - sectionViewDistance));
+    int endX = std::max(minSectionX, std::min(maxSectionX, currentSectionPos.x + sectionViewDistance + 1));
+    int endY = std::max(0, std::min(world->getSizeY() / SECTION_SIZE, currentSectionPos.y + sectionViewDistance + 1));
+    int endZ = std::max(minSectionZ, std::min(maxSectionZ, currentSectionPos.z + sectionViewDistance + 1));
 
     // Prepare for rendering
     glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
@@ -360,7 +317,7 @@ void Renderer::drawRegion(const glm::mat4 &viewMatrix, const glm::mat4 &projecti
     glUniform3fv(shaderSetup.cubeLightDirLoc, 1, glm::value_ptr(lightDirection));
     glBindVertexArray(geometrySetup.cubeVAO);
 
-    // Only render sections that are ready
+    // Only render sections that have a mesh, sections being meshed again keep their previous one
     std::unordered_map<uint8_t, std::unordered_map<uint8_t, std::vector<glm::vec3>>> allBlockPositions;
     std::unordered_map<uint8_t, glm::vec3> allBlockColors;
     for (int sx = startX; sx < endX; sx++)
@@ -371,13 +328,13 @@ void Renderer::drawRegion(const glm::mat4 &viewMatrix, const glm::mat4 &projecti
             {
                 std::string sectionKey = getSectionKey(sx, sy, sz);
 
-                if (!isSectionReady(sectionKey))
+                auto blockFaces = getSectionFaces(sectionKey);
+                if (!blockFaces)
                 {
                     continue;
                 }
 
-                const auto &blockFaces = sectionCache[sectionKey].blockFaces;
-                for (const auto &[blockId, faces] : blockFaces)
+                for (const auto &[blockId, faces] : *blockFaces)
                 {
                     // Skip empty groups
                     if (faces.empty())
@@ -440,9 +397,9 @@ void Renderer::renderFrame(int windowWidth, int windowHeight, float nearPlane, f
 
     // Draw axes
     auto start = std::chrono::high_resolution_clock::now();
-    if (region)
+    if (world)
     {
-        drawRegion(viewMatrix, projectionMatrix);
+        drawWorld(viewMatrix, projectionMatrix);
     }
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<float, std::milli> duration = end - start;
@@ -476,9 +433,25 @@ void Renderer::startRenderLoop(Window &window)
  ****
  ******/
 
-void Renderer::setRegion(Region *region)
+void Renderer::setWorld(World *world, bool watchChanges)
 {
-    this->region = region;
+    if (this->world)
+    {
+        this->world->stopWatching();
+    }
+    chunkPrefetcher.reset();
+    sectionMesher.reset();
+    this->world = world;
+    if (world)
+    {
+        chunkPrefetcher = std::make_unique<ChunkPrefetcher>(*world);
+        sectionMesher = std::make_unique<SectionMesher>(*world, noRenderBlockIds);
+        if (watchChanges)
+        {
+            world->startWatching([this](const std::vector<std::tuple<int, int, int>> &sections)
+                                 { markSectionsChanged(sections); });
+        }
+    }
     sectionCache.clear();
 }
 
@@ -552,16 +525,44 @@ void Renderer::queueSectionForProcessing(int sx, int sy, int sz, const std::stri
     condition.notify_one();
 }
 
-bool Renderer::isSectionReady(const std::string &sectionKey)
+std::shared_ptr<const std::unordered_map<uint16_t, std::vector<BlockFace>>> Renderer::getSectionFaces(const std::string &sectionKey)
 {
     std::lock_guard<std::mutex> lock(cacheMutex);
 
-    if (sectionCache.find(sectionKey) == sectionCache.end())
+    auto it = sectionCache.find(sectionKey);
+    if (it == sectionCache.end())
     {
-        return false;
+        return nullptr;
     }
 
-    return !sectionCache[sectionKey].processing && !sectionCache[sectionKey].dirty;
+    return it->second.blockFaces;
+}
+
+void Renderer::markSectionsChanged(const std::vector<std::tuple<int, int, int>> &sections)
+{
+    // Faces on the borders of the neighbouring sections depend on these blocks too
+    const int neighbourOffsets[7][3] = {{0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (const auto &[sx, sy, sz] : sections)
+        {
+            for (const auto &offset : neighbourOffsets)
+            {
+                auto it = sectionCache.find(getSectionKey(sx + offset[0], sy + offset[1], sz + offset[2]));
+                if (it != sectionCache.end())
+                {
+                    it->second.version++;
+                }
+            }
+        }
+    }
+
+    // Queue the changed sections in view, the old faces are drawn until then
+    {
+        std::lock_guard<std::mutex> lock(discoveryMutex);
+        needsDiscoveryUpdate = true;
+    }
+    discoveryCondition.notify_one();
 }
 
 void Renderer::startSectionDiscovery()
@@ -606,7 +607,7 @@ void Renderer::sectionDiscoveryFunction()
             shouldProcess = true;
         }
         
-        if (shouldProcess && region)
+        if (shouldProcess && world)
         {
             // Mark out of range sections as dirty
             {
@@ -630,12 +631,16 @@ void Renderer::sectionDiscoveryFunction()
             }
 
             // Calculate visible section range
-            int startX = std::max(0, std::min(region->getSizeX() / SECTION_SIZE, currentSectionPos.x - sectionViewDistance));
-            int startY = std::max(0, std::min(region->getSizeY() / SECTION_SIZE, currentSectionPos.y - sectionViewDistance));
-            int startZ = std::max(0, std::min(region->getSizeZ() / SECTION_SIZE, currentSectionPos.z - sectionViewDistance));
-            int endX = std::max(0, std::min(region->getSizeX() / SECTION_SIZE, currentSectionPos.x + sectionViewDistance + 1));
-            int endY = std::max(0, std::min(region->getSizeY() / SECTION_SIZE, currentSectionPos.y + sectionViewDistance + 1));
-            int endZ = std::max(0, std::min(region->getSizeZ() / SECTION_SIZE, currentSectionPos.z + sectionViewDistance + 1));
+            int minSectionX = world->getMinX() / SECTION_SIZE;
+            int minSectionZ = world->getMinZ() / SECTION_SIZE;
+            int maxSectionX = world->getMaxX() / SECTION_SIZE;
+            int maxSectionZ = world->getMaxZ() / SECTION_SIZE;
+            int startX = std::max(minSectionX, std::min(maxSectionX, currentSectionPos.x - sectionViewDistance));
+            int startY = std::max(0, std::min(world->getSizeY() / SECTION_SIZE, currentSectionPos.y - sectionViewDistance));
+            int startZ = std::max(minSectionZ, std::min(maxSectionZ, currentSectionPos.z - sectionViewDistance));
+            int endX = std::max(minSectionX, std::min(maxSectionX, currentSectionPos.x + sectionViewDistance + 1));
+            int endY = std::max(0, std::min(world->getSizeY() / SECTION_SIZE, currentSectionPos.y + sectionViewDistance + 1));
+            int endZ = std::max(minSectionZ, std::min(maxSectionZ, currentSectionPos.z + sectionViewDistance + 1));
 
             // Queue sections for processing
             for (int sx = startX; sx < endX; sx++)
@@ -652,7 +657,8 @@ void Renderer::sectionDiscoveryFunction()
                         {
                             std::lock_guard<std::mutex> lock(cacheMutex);
                             needsProcessing = sectionCache.find(sectionKey) == sectionCache.end() ||
-                                             sectionCache[sectionKey].dirty;
+                                             sectionCache[sectionKey].dirty ||
+                                             sectionCache[sectionKey].version != sectionCache[sectionKey].meshedVersion;
                                              
                             if (needsProcessing && sectionCache.find(sectionKey) != sectionCache.end())
                             {
@@ -0,0 +1,146 @@
+#include "section_data.h"
+#include "section_unpacker.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+const uint16_t UNASSIGNED_INDEX = 0xFFFF;
+const size_t N_BLOCK_IDS = 1 << 16;
+
+SectionData::SectionData() : SectionData(0xFFFF)
+{
+}
+
+SectionData::SectionData(BlockId fill) : palette(1, fill), bitsPerBlock(0), bitsShift(0)
+{
+}
+
+std::shared_ptr<const SectionData> SectionData::getUniform(BlockId blockId)
+{
+    static std::mutex uniformMutex;
+    static std::unordered_map<BlockId, std::shared_ptr<const SectionData>> uniformSections;
+
+    std::lock_guard<std::mutex> lock(uniformMutex);
+    std::shared_ptr<const SectionData> &section = uniformSections[blockId];
+    if (!section)
+    {
+        section = std::make_shared<const SectionData>(blockId);
+    }
+    return section;
+}
+
+const SectionData &SectionData::getMissing()
+{
+    static const SectionData missing;
+    return missing;
+}
+
+SectionData::SectionData(const std::vector<BlockId> &paletteIds, const uint16_t *indices) : bitsPerBlock(0), bitsShift(0)
+{
+    // Local index of every block ID, shared by the sections packed on this thread and
+    // cleaned up after each one. The on-disk palette maps to it lazily so unused or
+    // duplicate entries never reach the local palette.
+    thread_local std::vector<uint16_t> localIndexById(N_BLOCK_IDS, UNASSIGNED_INDEX);
+    std::vector<uint16_t> localIndexByEntry(paletteIds.size() + 1, UNASSIGNED_INDEX);
+
+    uint16_t localIndices[TOTAL_SECTION_BLOCKS];
+    for (int i = 0; i < TOTAL_SECTION_BLOCKS; ++i)
+    {
+        size_t entry = std::min<size_t>(indices[i], paletteIds.size());
+        uint16_t &localIndex = localIndexByEntry[entry];
+        if (localIndex == UNASSIGNED_INDEX)
+        {
+            BlockId blockId = entry < paletteIds.size() ? paletteIds[entry] : 0xFFFF;
+            uint16_t &indexForId = localIndexById[blockId];
+            if (indexForId == UNASSIGNED_INDEX)
+            {
+                indexForId = static_cast<uint16_t>(palette.size());
+                palette.push_back(blockId);
+            }
+            localIndex = indexForId;
+        }
+        localIndices[i] = localIndex;
+    }
+    for (BlockId blockId : palette)
+    {
+        localIndexById[blockId] = UNASSIGNED_INDEX;
+    }
+
+    if (palette.size() == 1)
+    {
+        return;
+    }
+
+    // Smallest power of two width that fits the palette
+    bitsShift = 0;
+    while ((1u << (1u << bitsShift)) < palette.size())
+    {
+        bitsShift++;
+    }
+    bitsPerBlock = static_cast<uint8_t>(1 << bitsShift);
+
+    // Pack the local indices
+    words.assign(TOTAL_SECTION_BLOCKS * bitsPerBlock / 64, 0);
+    for (int i = 0; i < TOTAL_SECTION_BLOCKS; ++i)
+    {
+        words[i >> (6 - bitsShift)] |= static_cast<uint64_t>(localIndices[i]) << ((i << bitsShift) & 63);
+    }
+}
+
+SectionData::SectionData(std::vector<BlockId> palette, std::vector<uint64_t> words)
+    : palette(std::move(palette)), words(std::move(words)), bitsPerBlock(0), bitsShift(0)
+{
+    if (this->palette.empty())
+    {
+        throw std::invalid_argument("Section palette is empty");
+    }
+    if (this->words.empty())
+    {
+        return;
+    }
+
+    // The width follows from the number of words
+    while (bitsShift < 4 && TOTAL_SECTION_BLOCKS * (1u << bitsShift) / 64 < this->words.size())
+    {
+        bitsShift++;
+    }
+    bitsPerBlock = static_cast<uint8_t>(1 << bitsShift);
+    if (TOTAL_SECTION_BLOCKS * bitsPerBlock / 64 != this->words.size())
+    {
+        throw std::invalid_argument("Invalid section word count: " + std::to_string(this->words.size()));
+    }
+
+    // Indices past the palette are only possible when it does not fill the width
+    if (this->palette.size() < (1u << bitsPerBlock))
+    {
+        uint16_t indices[TOTAL_SECTION_BLOCKS];
+        unpackSectionIndices(this->words.data(), this->words.size(), bitsPerBlock, indices);
+        if (*std::max_element(indices, indices + TOTAL_SECTION_BLOCKS) >= this->palette.size())
+        {
+            throw std::invalid_argument("Section index outside the palette");
+        }
+    }
+}
+
+void SectionData::unpack(BlockId *output) const
+{
+    if (bitsPerBlock == 0)
+    {
+        std::fill(output, output + TOTAL_SECTION_BLOCKS, palette[0]);
+        return;
+    }
+
+    unpackSectionIndices(words.data(), words.size(), bitsPerBlock, output);
+    for (int i = 0; i < TOTAL_SECTION_BLOCKS; ++i)
+    {
+        output[i] = palette[output[i]];
+    }
+}
+
+size_t SectionData::getMemoryUsage() const
+{
+    return palette.capacity() * sizeof(BlockId) + words.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,374 @@
+#include "section_disk_cache.h"
+#include <zlib/zlib.h>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+const char CACHE_MAGIC[8] = {'B', 'S', 'S', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t CACHE_VERSION = 1;
+const int N_CHUNKS_PER_REGION = N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ;
+
+const uint8_t MISSING_SECTION = 0;
+const uint8_t UNIFORM_SECTION = 1;
+const uint8_t PALETTED_SECTION = 2;
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t regionPathLength;
+    uint64_t dictionaryHash;
+};
+
+// Header, region path padded to 8 bytes, then the chunk table
+static size_t getChunkTableOffset(size_t regionPathLength)
+{
+    return sizeof(CacheHeader) + (regionPathLength + 7) / 8 * 8;
+}
+
+/*****
+ ****
+ *** Chunk layout
+ ****
+ ******/
+
+template <typename T>
+static void append(std::vector<char> &output, const T *values, size_t count)
+{
+    const char *bytes = reinterpret_cast<const char *>(values);
+    output.insert(output.end(), bytes, bytes + count * sizeof(T));
+}
+
+template <typename T>
+static void consume(const char *&data, const char *end, T *values, size_t count)
+{
+    if (static_cast<size_t>(end - data) < count * sizeof(T))
+    {
+        throw std::runtime_error("Cached chunk is truncated");
+    }
+    std::memcpy(values, data, count * sizeof(T));
+    data += count * sizeof(T);
+}
+
+std::vector<char> SectionDiskCache::serializeChunk(const ChunkData &chunk)
+{
+    // Per section: kind, then the palette and words of paletted sections or the ID of uniform ones
+    std::vector<char> output;
+    uint32_t nSections = static_cast<uint32_t>(chunk.size());
+    append(output, &nSections, 1);
+    for (const SectionPtr &section : chunk)
+    {
+        uint8_t kind = !section ? MISSING_SECTION : section->isUniform() ? UNIFORM_SECTION : PALETTED_SECTION;
+        append(output, &kind, 1);
+        if (kind == UNIFORM_SECTION)
+        {
+            append(output, section->getPalette().data(), 1);
+        }
+        else if (kind == PALETTED_SECTION)
+        {
+            uint16_t paletteSize = static_cast<uint16_t>(section->getPalette().size());
+            uint16_t nWords = static_cast<uint16_t>(section->getWords().size());
+            append(output, &paletteSize, 1);
+            append(output, &nWords, 1);
+            append(output, section->getPalette().data(), paletteSize);
+            append(output, section->getWords().data(), nWords);
+        }
+    }
+
+    return output;
+}
+
+ChunkData SectionDiskCache::deserializeChunk(const char *data, size_t size)
+{
+    const char *end = data + size;
+    uint32_t nSections;
+    consume(data, end, &nSections, 1);
+    if (nSections > N_SECTIONS_PER_CHUNK_Y)
+    {
+        throw std::runtime_error("Invalid cached section count: " + std::to_string(nSections));
+    }
+
+    ChunkData chunk(N_SECTIONS_PER_CHUNK_Y);
+    for (uint32_t sectionYIndex = 0; sectionYIndex < nSections; ++sectionYIndex)
+    {
+        uint8_t kind;
+        consume(data, end, &kind, 1);
+        if (kind == UNIFORM_SECTION)
+        {
+            BlockId blockId;
+            consume(data, end, &blockId, 1);
+            chunk[sectionYIndex] = SectionData::getUniform(blockId);
+        }
+        else if (kind == PALETTED_SECTION)
+        {
+            uint16_t paletteSize;
+            uint16_t nWords;
+            consume(data, end, &paletteSize, 1);
+            consume(data, end, &nWords, 1);
+            std::vector<BlockId> palette(paletteSize);
+            std::vector<uint64_t> words(nWords);
+            consume(data, end, palette.data(), paletteSize);
+            consume(data, end, words.data(), nWords);
+            chunk[sectionYIndex] = std::make_shared<const SectionData>(std::move(palette), std::move(words));
+        }
+        else if (kind != MISSING_SECTION)
+        {
+            throw std::runtime_error("Invalid cached section kind: " + std::to_string(kind));
+        }
+    }
+
+    return chunk;
+}
+
+/*****
+ ****
+ *** Cache file
+ ****
+ ******/
+
+SectionDiskCache::SectionDiskCache(
+    const std::filesystem::path &cachePath,
+    const std::filesystem::path &regionPath,
+    uint64_t dictionaryHash,
+    Compression compression)
+    : cachePath(cachePath),
+      regionPath(std::filesystem::absolute(regionPath).string()),
+      dictionaryHash(dictionaryHash),
+      compression(compression),
+      storedEntries(N_CHUNKS_PER_REGION, ChunkEntry{}),
+      storedChunks(N_CHUNKS_PER_REGION),
+      nStoredChunks(0)
+{
+    map();
+}
+
+void SectionDiskCache::map()
+{
+    mapping.reset();
+    mappedEntries.assign(N_CHUNKS_PER_REGION, ChunkEntry{});
+    if (!std::filesystem::exists(cachePath))
+    {
+        return;
+    }
+
+    try
+    {
+        mapping = std::make_unique<RegionFile>(cachePath, RegionFile::AccessPattern::Random);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Ignoring section cache: " << e.what() << std::endl;
+        return;
+    }
+
+    // Caches built from another region file, another dictionary or by another version are ignored
+    CacheHeader header;
+    size_t chunkTableOffset = getChunkTableOffset(this->regionPath.size());
+    size_t dataOffset = chunkTableOffset + N_CHUNKS_PER_REGION * sizeof(ChunkEntry);
+    bool valid = mapping->size() >= dataOffset;
+    if (valid)
+    {
+        std::memcpy(&header, mapping->data(), sizeof(header));
+        valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                header.version == CACHE_VERSION &&
+                header.dictionaryHash == dictionaryHash &&
+                header.regionPathLength == this->regionPath.size() &&
+                std::memcmp(mapping->data() + sizeof(header), this->regionPath.data(), this->regionPath.size()) == 0;
+    }
+    if (!valid)
+    {
+        mapping.reset();
+        return;
+    }
+
+    // Entries pointing outside the file are dropped
+    std::memcpy(mappedEntries.data(), mapping->data() + chunkTableOffset, N_CHUNKS_PER_REGION * sizeof(ChunkEntry));
+    for (ChunkEntry &entry : mappedEntries)
+    {
+        if (entry.offset < dataOffset || entry.offset > mapping->size() || entry.storedSize > mapping->size() - entry.offset)
+        {
+            entry = ChunkEntry{};
+        }
+    }
+}
+
+SectionDiskCache::~SectionDiskCache()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to write section cache " << cachePath.string() << ": " << e.what() << std::endl;
+    }
+}
+
+std::filesystem::path SectionDiskCache::getCachePath(const std::filesystem::path &cacheDirectory, const std::filesystem::path &regionPath)
+{
+    // Region files of different worlds share names, the path hash tells them apart
+    std::ostringstream fileName;
+    fileName << regionPath.stem().string() << "."
+             << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>()(std::filesystem::absolute(regionPath).string())
+             << ".sections";
+    return cacheDirectory / fileName.str();
+}
+
+bool SectionDiskCache::readChunk(int chunkIdx, uint32_t timestamp, uint32_t location, ChunkData &chunk) const
+{
+    std::shared_lock<std::shared_mutex> lock(mappingMutex);
+    const ChunkEntry &entry = mappedEntries[chunkIdx];
+    if (!mapping || entry.location == 0 || entry.location != location || entry.timestamp != timestamp)
+    {
+        return false;
+    }
+
+    // A damaged entry falls back to decoding the region
+    try
+    {
+        const char *stored = mapping->data() + entry.offset;
+        if (entry.compression == static_cast<uint32_t>(Compression::None))
+        {
+            chunk = deserializeChunk(stored, entry.storedSize);
+            return true;
+        }
+        if (entry.compression == static_cast<uint32_t>(Compression::Zlib))
+        {
+            thread_local std::vector<char> inflated;
+            inflated.resize(entry.rawSize);
+            uLongf inflatedSize = entry.rawSize;
+            if (uncompress(reinterpret_cast<Bytef *>(inflated.data()), &inflatedSize, reinterpret_cast<const Bytef *>(stored), entry.storedSize) != Z_OK)
+            {
+                throw std::runtime_error("Failed to inflate cached chunk");
+            }
+            chunk = deserializeChunk(inflated.data(), inflatedSize);
+            return true;
+        }
+        throw std::runtime_error("Unsupported cache compression: " + std::to_string(entry.compression));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Ignoring cached chunk: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void SectionDiskCache::storeChunk(int chunkIdx, uint32_t timestamp, uint32_t location, const ChunkData &chunk)
+{
+    // Serialize and compress outside the lock
+    std::vector<char> raw = serializeChunk(chunk);
+    ChunkEntry entry = {timestamp, location, static_cast<uint32_t>(compression), static_cast<uint32_t>(raw.size()), 0, raw.size()};
+    std::vector<char> stored;
+    if (compression == Compression::Zlib)
+    {
+        uLongf storedSize = compressBound(raw.size());
+        stored.resize(storedSize);
+        if (compress2(reinterpret_cast<Bytef *>(stored.data()), &storedSize, reinterpret_cast<const Bytef *>(raw.data()), raw.size(), Z_BEST_SPEED) != Z_OK)
+        {
+            throw std::runtime_error("Failed to compress chunk for the section cache");
+        }
+        stored.resize(storedSize);
+        entry.storedSize = storedSize;
+    }
+    else
+    {
+        stored = std::move(raw);
+    }
+
+    std::lock_guard<std::mutex> lock(storedMutex);
+    nStoredChunks += storedEntries[chunkIdx].location == 0;
+    storedEntries[chunkIdx] = entry;
+    storedChunks[chunkIdx] = std::move(stored);
+}
+
+size_t SectionDiskCache::getCachedChunkCount() const
+{
+    std::shared_lock<std::shared_mutex> lock(mappingMutex);
+    size_t nCachedChunks = 0;
+    for (const ChunkEntry &entry : mappedEntries)
+    {
+        nCachedChunks += entry.location != 0;
+    }
+    return nCachedChunks;
+}
+
+void SectionDiskCache::flush()
+{
+    std::lock_guard<std::mutex> lock(storedMutex);
+    if (nStoredChunks == 0)
+    {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> mappingLock(mappingMutex);
+
+    // Stored chunks replace mapped ones, the others are copied over as they are
+    size_t chunkTableOffset = getChunkTableOffset(regionPath.size());
+    std::vector<char> output(chunkTableOffset + N_CHUNKS_PER_REGION * sizeof(ChunkEntry), 0);
+    std::vector<ChunkEntry> entries(N_CHUNKS_PER_REGION, ChunkEntry{});
+    for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION; ++chunkIdx)
+    {
+        const char *stored = nullptr;
+        if (storedEntries[chunkIdx].location != 0)
+        {
+            entries[chunkIdx] = storedEntries[chunkIdx];
+            stored = storedChunks[chunkIdx].data();
+        }
+        else if (mappedEntries[chunkIdx].location != 0)
+        {
+            entries[chunkIdx] = mappedEntries[chunkIdx];
+            stored = mapping->data() + mappedEntries[chunkIdx].offset;
+        }
+        else
+        {
+            continue;
+        }
+
+        entries[chunkIdx].offset = output.size();
+        output.insert(output.end(), stored, stored + entries[chunkIdx].storedSize);
+    }
+
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.regionPathLength = static_cast<uint32_t>(regionPath.size());
+    header.dictionaryHash = dictionaryHash;
+    std::memcpy(output.data(), &header, sizeof(header));
+    std::memcpy(output.data() + sizeof(header), regionPath.data(), regionPath.size());
+    std::memcpy(output.data() + chunkTableOffset, entries.data(), entries.size() * sizeof(ChunkEntry));
+
+    // Write next to the cache file, readers of the old file never see a partial one
+    std::filesystem::create_directories(cachePath.parent_path());
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(output.data(), output.size());
+        if (!file)
+        {
+            throw std::runtime_error("Failed to write " + temporaryPath.string());
+        }
+    }
+
+    // Unmap before replacing, mapped files cannot be replaced everywhere. A failed replace
+    // keeps the stored chunks and maps the old file again.
+    mapping.reset();
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, cachePath, error);
+    if (!error)
+    {
+        storedEntries.assign(N_CHUNKS_PER_REGION, ChunkEntry{});
+        storedChunks.assign(N_CHUNKS_PER_REGION, std::vector<char>());
+        nStoredChunks = 0;
+    }
+    map();
+    if (error)
+    {
+        throw std::runtime_error("Failed to replace " + cachePath.string() + ": " + error.message());
+    }
+}
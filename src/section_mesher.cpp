@@ -0,0 +1,137 @@
+#include "section_mesher.h"
+#include <algorithm>
+#include <utility>
+
+SectionMesher::SectionMesher(const World &world, std::vector<uint16_t> noRenderBlockIds)
+    : world(world), noRenderBlockIds(std::move(noRenderBlockIds))
+{
+}
+
+bool SectionMesher::isRenderableBlock(uint16_t blockId) const
+{
+    if (blockId == 0xFFFF)
+    {
+        return false;
+    }
+
+    if (std::find(noRenderBlockIds.begin(), noRenderBlockIds.end(), blockId) != noRenderBlockIds.end())
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool SectionMesher::blockExists(int x, int y, int z) const
+{
+    // Blocks outside the world are missing
+    return isRenderableBlock(world.getBlockAt(x, y, z));
+}
+
+std::unordered_map<uint16_t, std::vector<BlockFace>> SectionMesher::getSectionFaces(int sx, int sy, int sz) const
+{
+    std::unordered_map<uint16_t, std::vector<BlockFace>> blockFaces;
+
+    int sectionStartX = sx * 16;
+    int sectionStartY = sy * 16;
+    int sectionStartZ = sz * 16;
+    int sectionEndX = (sx + 1) * 16;
+    int sectionEndY = std::min((sy + 1) * 16, world.getSizeY());
+    int sectionEndZ = (sz + 1) * 16;
+
+    // Uniform sections: nothing to mesh for air, and only faces on the section boundary can be visible for solids
+    if (world.isSectionUniform(sx, sy, sz))
+    {
+        const uint16_t blockId = world.getUniformBlockId(sx, sy, sz);
+        if (isRenderableBlock(blockId))
+        {
+            std::vector<BlockFace> &faces = blockFaces[blockId];
+            for (int y = sectionStartY; y < sectionEndY; y++)
+            {
+                for (int z = sectionStartZ; z < sectionEndZ; z++)
+                {
+                    if (!blockExists(sectionEndX, y, z))
+                    {
+                        faces.push_back({glm::vec3(sectionEndX - 1, y, z), 0});
+                    }
+                    if (!blockExists(sectionStartX - 1, y, z))
+                    {
+                        faces.push_back({glm::vec3(sectionStartX, y, z), 1});
+                    }
+                }
+            }
+            for (int x = sectionStartX; x < sectionEndX; x++)
+            {
+                for (int z = sectionStartZ; z < sectionEndZ; z++)
+                {
+                    if (!blockExists(x, sectionEndY, z))
+                    {
+                        faces.push_back({glm::vec3(x, sectionEndY - 1, z), 2});
+                    }
+                    if (!blockExists(x, sectionStartY - 1, z))
+                    {
+                        faces.push_back({glm::vec3(x, sectionStartY, z), 3});
+                    }
+                }
+                for (int y = sectionStartY; y < sectionEndY; y++)
+                {
+                    if (!blockExists(x, y, sectionEndZ))
+                    {
+                        faces.push_back({glm::vec3(x, y, sectionEndZ - 1), 4});
+                    }
+                    if (!blockExists(x, y, sectionStartZ - 1))
+                    {
+                        faces.push_back({glm::vec3(x, y, sectionStartZ), 5});
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        for (int x = sectionStartX; x < sectionEndX; x++)
+        {
+            for (int y = sectionStartY; y < sectionEndY; y++)
+            {
+                for (int z = sectionStartZ; z < sectionEndZ; z++)
+                {
+                    const uint16_t blockId = world.getBlockAt(x, y, z);
+
+                    // Skip non-renderable blocks
+                    if (!isRenderableBlock(blockId))
+                    {
+                        continue;
+                    }
+
+                    // Check if block is visible and skip non-visible blocks
+                    if (!blockExists(x + 1, y, z))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 0});
+                    }
+                    if (!blockExists(x - 1, y, z))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 1});
+                    }
+                    if (!blockExists(x, y + 1, z))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 2});
+                    }
+                    if (!blockExists(x, y - 1, z))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 3});
+                    }
+                    if (!blockExists(x, y, z + 1))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 4});
+                    }
+                    if (!blockExists(x, y, z - 1))
+                    {
+                        blockFaces[blockId].push_back({glm::vec3(x, y, z), 5});
+                    }
+                }
+            }
+        }
+    }
+
+    return blockFaces;
+}
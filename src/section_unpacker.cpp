@@ -0,0 +1,180 @@
+#include "section_unpacker.h"
+#include "cpu_features.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using UnpackKernel = void (*)(const uint64_t *packed, size_t packedLength, uint16_t *output);
+
+/*****
+ ****
+ *** Scalar kernels
+ ****
+ ******/
+
+// Unpacks from the given long on, the indices before it are already written
+template <int Bits>
+static void unpackScalarFrom(const uint64_t *packed, size_t packedLength, size_t firstLong, uint16_t *output)
+{
+    constexpr int indicesPerLong = 64 / Bits;
+    constexpr uint64_t mask = (1ULL << Bits) - 1;
+    constexpr size_t fullLongs = TOTAL_SECTION_BLOCKS / indicesPerLong;
+
+    size_t longIdx = firstLong;
+    for (; longIdx < std::min(packedLength, fullLongs); ++longIdx)
+    {
+        uint64_t value = packed[longIdx];
+        uint16_t *out = output + longIdx * indicesPerLong;
+        for (int i = 0; i < indicesPerLong; ++i)
+        {
+            out[i] = static_cast<uint16_t>((value >> (i * Bits)) & mask);
+        }
+    }
+
+    // The last long is only partly used when the width does not divide the section
+    size_t written = longIdx * indicesPerLong;
+    if (longIdx == fullLongs && longIdx < packedLength)
+    {
+        uint64_t value = packed[longIdx];
+        for (; written < TOTAL_SECTION_BLOCKS; ++written, value >>= Bits)
+        {
+            output[written] = static_cast<uint16_t>(value & mask);
+        }
+    }
+
+    // Blocks past the end of a short array
+    std::fill(output + std::min<size_t>(written, TOTAL_SECTION_BLOCKS), output + TOTAL_SECTION_BLOCKS, 0xFFFF);
+}
+
+template <int Bits>
+static void unpackScalar(const uint64_t *packed, size_t packedLength, uint16_t *output)
+{
+    unpackScalarFrom<Bits>(packed, packedLength, 0, output);
+}
+
+#ifdef SIMD_X86
+
+/*****
+ ****
+ *** AVX2 kernels
+ ****
+ ******/
+
+// Each long is broadcast to four 64-bit lanes and shifted by a different multiple of the
+// width per lane. Even and odd indices are merged into 32-bit lanes, then packed to 16 bits.
+template <int Bits>
+TARGET_AVX2 static void unpackAVX2(const uint64_t *packed, size_t packedLength, uint16_t *output)
+{
+    constexpr int indicesPerLong = 64 / Bits;
+    constexpr int indicesPerStore = indicesPerLong > 8 ? 16 : 8;
+
+    const __m256i mask = _mm256_set1_epi64x((1LL << Bits) - 1);
+    const __m256i evenShifts = _mm256_setr_epi64x(0 * Bits, 2 * Bits, 4 * Bits, 6 * Bits);
+    const __m256i oddShifts = _mm256_setr_epi64x(1 * Bits, 3 * Bits, 5 * Bits, 7 * Bits);
+    const __m256i highEvenShifts = _mm256_setr_epi64x(8 * Bits, 10 * Bits, 12 * Bits, 14 * Bits);
+    const __m256i highOddShifts = _mm256_setr_epi64x(9 * Bits, 11 * Bits, 13 * Bits, 15 * Bits);
+
+    // Stores write a few indices past the long, which the next long overwrites. Stop while
+    // they still fit in the output and let the scalar kernel finish.
+    size_t vectorLongs = std::min<size_t>(packedLength, (TOTAL_SECTION_BLOCKS - indicesPerStore) / indicesPerLong + 1);
+
+    for (size_t longIdx = 0; longIdx < vectorLongs; ++longIdx)
+    {
+        __m256i value = _mm256_set1_epi64x(static_cast<long long>(packed[longIdx]));
+        __m256i even = _mm256_and_si256(_mm256_srlv_epi64(value, evenShifts), mask);
+        __m256i odd = _mm256_and_si256(_mm256_srlv_epi64(value, oddShifts), mask);
+        __m256i low = _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+
+        uint16_t *out = output + longIdx * indicesPerLong;
+        if constexpr (indicesPerStore == 16)
+        {
+            __m256i highEven = _mm256_and_si256(_mm256_srlv_epi64(value, highEvenShifts), mask);
+            __m256i highOdd = _mm256_and_si256(_mm256_srlv_epi64(value, highOddShifts), mask);
+            __m256i high = _mm256_or_si256(highEven, _mm256_slli_epi64(highOdd, 32));
+            __m256i indices = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), indices);
+        }
+        else
+        {
+            __m256i indices = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, low), 0xD8);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(indices));
+        }
+    }
+
+    unpackScalarFrom<Bits>(packed, packedLength, vectorLongs, output);
+}
+
+// Widths under 4 pack more than 16 indices per long and only occur in biome data
+template <int Bits>
+static void unpackAVX2OrScalar(const uint64_t *packed, size_t packedLength, uint16_t *output)
+{
+    if constexpr (Bits < 4)
+    {
+        unpackScalar<Bits>(packed, packedLength, output);
+    }
+    else
+    {
+        unpackAVX2<Bits>(packed, packedLength, output);
+    }
+}
+
+#endif
+
+/*****
+ ****
+ *** Dispatch
+ ****
+ ******/
+
+struct UnpackKernels
+{
+    UnpackKernel byBitLength[MAX_SECTION_BIT_LENGTH + 1];
+    const char *name;
+};
+
+template <size_t... Widths>
+static UnpackKernels makeScalarKernels(std::index_sequence<Widths...>)
+{
+    return {{nullptr, unpackScalar<Widths + 1>...}, "scalar"};
+}
+
+#ifdef SIMD_X86
+template <size_t... Widths>
+static UnpackKernels makeAVX2Kernels(std::index_sequence<Widths...>)
+{
+    return {{nullptr, unpackAVX2OrScalar<Widths + 1>...}, "avx2"};
+}
+#endif
+
+static UnpackKernels selectUnpackKernels()
+{
+#ifdef SIMD_X86
+    if (cpuHasAVX2())
+    {
+        return makeAVX2Kernels(std::make_index_sequence<MAX_SECTION_BIT_LENGTH>());
+    }
+#endif
+    return makeScalarKernels(std::make_index_sequence<MAX_SECTION_BIT_LENGTH>());
+}
+
+static const UnpackKernels &getUnpackKernels()
+{
+    static const UnpackKernels kernels = selectUnpackKernels();
+    return kernels;
+}
+
+void unpackSectionIndices(const uint64_t *packed, size_t packedLength, int bitLength, uint16_t *output)
+{
+    if (bitLength <= 0 || bitLength > MAX_SECTION_BIT_LENGTH)
+    {
+        throw std::invalid_argument("Invalid bit length: " + std::to_string(bitLength));
+    }
+
+    getUnpackKernels().byBitLength[bitLength](packed, packedLength, output);
+}
+
+const char *getSectionUnpackKernelName()
+{
+    return getUnpackKernels().name;
+}
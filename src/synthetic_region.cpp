@@ -0,0 +1,456 @@
+#include "synthetic_region.h"
+#include "nbt_parser.h"
+#include <zlib/zlib.h>
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+const int32_t SYNTHETIC_DATA_VERSION = 3465;
+const uint32_t SYNTHETIC_TIMESTAMP = 1700000000;
+const int N_HEIGHTMAP_LONGS = 37; // 256 heights of 9 bits
+const int N_LIGHT_BYTES = 2048;
+
+const char LZ4_BLOCK_MAGIC[] = {'L', 'Z', '4', 'B', 'l', 'o', 'c', 'k'};
+const uint8_t LZ4_METHOD_RAW = 0x10;
+const int LZ4_BLOCK_LEVEL = 6; // 64 KiB blocks, as the game writes them
+const size_t LZ4_BLOCK_BYTES = size_t(1) << (10 + LZ4_BLOCK_LEVEL);
+const uint32_t LZ4_CHECKSUM_SEED = 0x9747B28C; // lz4-java's default XXHash32 seed
+const uint32_t LZ4_CHECKSUM_MASK = 0x0FFFFFFF; // lz4-java keeps the low 28 bits
+
+using TagType = NBTParser::TagType;
+
+/*****
+ ****
+ *** NBT writing
+ ****
+ ******/
+
+template <typename T>
+static void writeBigEndian(std::vector<char> &out, T value)
+{
+    for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+    {
+        out.push_back(static_cast<char>(static_cast<uint64_t>(value) >> shift));
+    }
+}
+
+static void writeLittleEndian32(std::vector<char> &out, uint32_t value)
+{
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        out.push_back(static_cast<char>(value >> shift));
+    }
+}
+
+static void writeString(std::vector<char> &out, std::string_view value)
+{
+    writeBigEndian<uint16_t>(out, static_cast<uint16_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static void beginTag(std::vector<char> &out, TagType type, std::string_view name)
+{
+    out.push_back(static_cast<char>(type));
+    writeString(out, name);
+}
+
+static void beginList(std::vector<char> &out, std::string_view name, TagType elementType, int32_t length)
+{
+    beginTag(out, TagType::TagList, name);
+    out.push_back(static_cast<char>(elementType));
+    writeBigEndian<int32_t>(out, length);
+}
+
+static void endCompound(std::vector<char> &out)
+{
+    out.push_back(static_cast<char>(TagType::TagEnd));
+}
+
+/*****
+ ****
+ *** LZ4 checksums
+ ****
+ ******/
+
+const uint32_t XXH_PRIME_1 = 2654435761U;
+const uint32_t XXH_PRIME_2 = 2246822519U;
+const uint32_t XXH_PRIME_3 = 3266489917U;
+const uint32_t XXH_PRIME_4 = 668265263U;
+const uint32_t XXH_PRIME_5 = 374761393U;
+
+static uint32_t rotateLeft(uint32_t value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+static uint32_t readLane(const unsigned char *bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+// XXHash32, which lz4-java checks every block against
+static uint32_t hashXXH32(const char *data, size_t size, uint32_t seed)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    const unsigned char *end = bytes + size;
+    uint32_t hash;
+
+    // Four accumulators over 16-byte stripes
+    if (size >= 16)
+    {
+        uint32_t accumulators[4] = {seed + XXH_PRIME_1 + XXH_PRIME_2, seed + XXH_PRIME_2, seed, seed - XXH_PRIME_1};
+        for (; bytes + 16 <= end; bytes += 16)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                accumulators[i] = rotateLeft(accumulators[i] + readLane(bytes + 4 * i) * XXH_PRIME_2, 13) * XXH_PRIME_1;
+            }
+        }
+        hash = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) + rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18);
+    }
+    else
+    {
+        hash = seed + XXH_PRIME_5;
+    }
+    hash += static_cast<uint32_t>(size);
+
+    // Remaining words, then bytes
+    for (; bytes + 4 <= end; bytes += 4)
+    {
+        hash = rotateLeft(hash + readLane(bytes) * XXH_PRIME_3, 17) * XXH_PRIME_4;
+    }
+    for (; bytes < end; ++bytes)
+    {
+        hash = rotateLeft(hash + *bytes * XXH_PRIME_5, 11) * XXH_PRIME_1;
+    }
+
+    hash ^= hash >> 15;
+    hash *= XXH_PRIME_2;
+    hash ^= hash >> 13;
+    hash *= XXH_PRIME_3;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+/*****
+ ****
+ *** Random draws
+ ****
+ ******/
+
+// Below n, the modulo bias is negligible for the sizes used here
+static uint64_t drawIndex(std::mt19937_64 &random, uint64_t n)
+{
+    return random() % n;
+}
+
+// In [0, 1)
+static double drawUnit(std::mt19937_64 &random)
+{
+    return (random() >> 11) * 0x1.0p-53;
+}
+
+// Uniform over the palette sizes unless weights are given
+static size_t drawPaletteSizeIdx(const SyntheticRegion::Options &options, std::mt19937_64 &random)
+{
+    if (options.paletteSizeWeights.empty())
+    {
+        return drawIndex(random, options.paletteSizes.size());
+    }
+
+    double draw = drawUnit(random) * std::accumulate(options.paletteSizeWeights.begin(), options.paletteSizeWeights.end(), 0.0);
+    for (size_t i = 0; i + 1 < options.paletteSizeWeights.size(); ++i)
+    {
+        draw -= options.paletteSizeWeights[i];
+        if (draw < 0.0)
+        {
+            return i;
+        }
+    }
+    return options.paletteSizeWeights.size() - 1;
+}
+
+/*****
+ ****
+ *** Chunks
+ ****
+ ******/
+
+static void writeSection(std::vector<char> &out, int sectionY, const SyntheticRegion::Options &options, std::mt19937_64 &random)
+{
+    beginTag(out, TagType::TagByte, "Y");
+    out.push_back(static_cast<char>(sectionY));
+
+    // Uniform sections are half air, paletted ones draw distinct blocks
+    bool checkerboard = options.pattern == SyntheticRegion::Pattern::Checkerboard;
+    std::vector<int> palette;
+    if (options.paletteSizes.empty() || drawUnit(random) < options.uniformSectionShare)
+    {
+        palette.push_back(drawIndex(random, 2) == 0 ? 0 : 1 + static_cast<int>(drawIndex(random, N_SYNTHETIC_BLOCKS - 1)));
+    }
+    else
+    {
+        int paletteSize = options.paletteSizes[drawPaletteSizeIdx(options, random)];
+        paletteSize = std::max(2, std::min(paletteSize, N_SYNTHETIC_BLOCKS));
+
+        // Checkerboards keep air first, the solid blocks follow
+        int firstBlock = checkerboard ? 1 : 0;
+        std::vector<int> blocks(N_SYNTHETIC_BLOCKS - firstBlock);
+        std::iota(blocks.begin(), blocks.end(), firstBlock);
+        if (checkerboard)
+        {
+            palette.push_back(0);
+        }
+        for (int i = 0; palette.size() < static_cast<size_t>(paletteSize); ++i)
+        {
+            std::swap(blocks[i], blocks[i + drawIndex(random, blocks.size() - i)]);
+            palette.push_back(blocks[i]);
+        }
+    }
+
+    beginTag(out, TagType::TagCompound, "block_states");
+    beginList(out, "palette", TagType::TagCompound, static_cast<int32_t>(palette.size()));
+    for (int blockIdx : palette)
+    {
+        beginTag(out, TagType::TagString, "Name");
+        writeString(out, "minecraft:" + SyntheticRegion::getBlockName(blockIdx));
+        endCompound(out);
+    }
+
+    // Indices never span two longs, as written since 1.16
+    if (palette.size() > 1)
+    {
+        int bitLength = 4;
+        while ((1u << bitLength) < palette.size())
+        {
+            bitLength++;
+        }
+        int indicesPerLong = 64 / bitLength;
+        int nLongs = (TOTAL_SECTION_BLOCKS + indicesPerLong - 1) / indicesPerLong;
+
+        beginTag(out, TagType::TagLongArray, "data");
+        writeBigEndian<int32_t>(out, nLongs);
+        for (int longIdx = 0; longIdx < nLongs; ++longIdx)
+        {
+            uint64_t value = 0;
+            for (int i = 0; i < indicesPerLong && longIdx * indicesPerLong + i < TOTAL_SECTION_BLOCKS; ++i)
+            {
+                // Blocks are stored in YZX order, sections have even sizes so the local parity is the global one
+                int blockIdx = longIdx * indicesPerLong + i;
+                uint64_t paletteIdx;
+                if (!checkerboard)
+                {
+                    paletteIdx = drawIndex(random, palette.size());
+                }
+                else if (((blockIdx >> 8) + (blockIdx >> 4) + blockIdx) & 1)
+                {
+                    paletteIdx = 0;
+                }
+                else
+                {
+                    paletteIdx = 1 + drawIndex(random, palette.size() - 1);
+                }
+                value |= paletteIdx << (i * bitLength);
+            }
+            writeBigEndian<uint64_t>(out, value);
+        }
+    }
+    endCompound(out);
+
+    beginTag(out, TagType::TagCompound, "biomes");
+    beginList(out, "palette", TagType::TagString, 1);
+    writeString(out, "minecraft:plains");
+    endCompound(out);
+
+    beginTag(out, TagType::TagByteArray, "BlockLight");
+    writeBigEndian<int32_t>(out, N_LIGHT_BYTES);
+    out.insert(out.end(), N_LIGHT_BYTES, 0);
+    beginTag(out, TagType::TagByteArray, "SkyLight");
+    writeBigEndian<int32_t>(out, N_LIGHT_BYTES);
+    out.insert(out.end(), N_LIGHT_BYTES, static_cast<char>(0xFF));
+
+    endCompound(out);
+}
+
+static void validateOptions(const SyntheticRegion::Options &options)
+{
+    if (options.chunkFillRatio < 0.0 || options.chunkFillRatio > 1.0)
+    {
+        throw std::invalid_argument("Chunk fill ratio must be between 0 and 1");
+    }
+    if (options.uniformSectionShare < 0.0 || options.uniformSectionShare > 1.0)
+    {
+        throw std::invalid_argument("Uniform section share must be between 0 and 1");
+    }
+    if (!options.paletteSizeWeights.empty())
+    {
+        if (options.paletteSizeWeights.size() != options.paletteSizes.size())
+        {
+            throw std::invalid_argument("Expected one weight per palette size");
+        }
+        if (std::any_of(options.paletteSizeWeights.begin(), options.paletteSizeWeights.end(), [](double weight)
+                        { return weight < 0.0; }) ||
+            std::accumulate(options.paletteSizeWeights.begin(), options.paletteSizeWeights.end(), 0.0) <= 0.0)
+        {
+            throw std::invalid_argument("Palette size weights must be non-negative, with a positive sum");
+        }
+    }
+}
+
+std::string SyntheticRegion::getBlockName(int blockIdx)
+{
+    return blockIdx == 0 ? "air" : "synthetic_" + std::to_string(blockIdx);
+}
+
+std::unordered_map<std::string, uint16_t> SyntheticRegion::getBlockIdDict()
+{
+    std::unordered_map<std::string, uint16_t> blockIdDict;
+    for (int blockIdx = 0; blockIdx < N_SYNTHETIC_BLOCKS; ++blockIdx)
+    {
+        blockIdDict[getBlockName(blockIdx)] = static_cast<uint16_t>(blockIdx);
+    }
+    return blockIdDict;
+}
+
+std::vector<char> SyntheticRegion::makeChunkNBT(int chunkX, int chunkZ, const Options &options, std::mt19937_64 &random)
+{
+    validateOptions(options);
+
+    std::vector<char> out;
+    beginTag(out, TagType::TagCompound, "");
+    beginTag(out, TagType::TagInt, "DataVersion");
+    writeBigEndian<int32_t>(out, SYNTHETIC_DATA_VERSION);
+    beginTag(out, TagType::TagInt, "xPos");
+    writeBigEndian<int32_t>(out, chunkX);
+    beginTag(out, TagType::TagInt, "zPos");
+    writeBigEndian<int32_t>(out, chunkZ);
+    beginTag(out, TagType::TagInt, "yPos");
+    writeBigEndian<int32_t>(out, MIN_Y / SECTION_SIZE);
+    beginTag(out, TagType::TagString, "Status");
+    writeString(out, "minecraft:full");
+    beginTag(out, TagType::TagLong, "LastUpdate");
+    writeBigEndian<int64_t>(out, 0);
+
+    beginList(out, "sections", TagType::TagCompound, N_SECTIONS_PER_CHUNK_Y);
+    for (int sectionIdx = 0; sectionIdx < N_SECTIONS_PER_CHUNK_Y; ++sectionIdx)
+    {
+        writeSection(out, sectionIdx + MIN_Y / SECTION_SIZE, options, random);
+    }
+
+    beginTag(out, TagType::TagCompound, "Heightmaps");
+    for (const char *heightmap : {"MOTION_BLOCKING", "WORLD_SURFACE"})
+    {
+        beginTag(out, TagType::TagLongArray, heightmap);
+        writeBigEndian<int32_t>(out, N_HEIGHTMAP_LONGS);
+        for (int i = 0; i < N_HEIGHTMAP_LONGS; ++i)
+        {
+            writeBigEndian<uint64_t>(out, random());
+        }
+    }
+    endCompound(out);
+
+    beginList(out, "block_entities", TagType::TagEnd, 0);
+    endCompound(out);
+    return out;
+}
+
+std::vector<char> SyntheticRegion::compressChunk(const std::vector<char> &nbt, ChunkCompression compression)
+{
+    if (compression == ChunkCompression::Uncompressed)
+    {
+        return nbt;
+    }
+    if (compression == ChunkCompression::LZ4)
+    {
+        // Stored blocks then an empty one, which ends the stream, as lz4-java's LZ4BlockInputStream reads them
+        std::vector<char> compressed;
+        uint32_t blockLength;
+        for (size_t offset = 0;; offset += blockLength)
+        {
+            blockLength = static_cast<uint32_t>(std::min(LZ4_BLOCK_BYTES, nbt.size() - offset));
+            compressed.insert(compressed.end(), std::begin(LZ4_BLOCK_MAGIC), std::end(LZ4_BLOCK_MAGIC));
+            compressed.push_back(static_cast<char>(LZ4_METHOD_RAW | LZ4_BLOCK_LEVEL));
+            writeLittleEndian32(compressed, blockLength);
+            writeLittleEndian32(compressed, blockLength);
+            writeLittleEndian32(compressed, blockLength == 0 ? 0 : hashXXH32(nbt.data() + offset, blockLength, LZ4_CHECKSUM_SEED) & LZ4_CHECKSUM_MASK);
+            if (blockLength == 0)
+            {
+                break;
+            }
+            compressed.insert(compressed.end(), nbt.begin() + offset, nbt.begin() + offset + blockLength);
+        }
+        return compressed;
+    }
+    if (compression != ChunkCompression::Zlib && compression != ChunkCompression::Gzip)
+    {
+        throw std::invalid_argument("Unsupported synthetic chunk compression: " + std::to_string(static_cast<int>(compression)));
+    }
+
+    // Default level, as the game writes them
+    z_stream stream = {};
+    int windowBits = compression == ChunkCompression::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("Failed to initialize deflate");
+    }
+    std::vector<char> compressed(deflateBound(&stream, static_cast<uLong>(nbt.size())));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(nbt.data()));
+    stream.avail_in = static_cast<uInt>(nbt.size());
+    stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    int result = deflate(&stream, Z_FINISH);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END)
+    {
+        throw std::runtime_error("Failed to compress chunk");
+    }
+    return compressed;
+}
+
+void SyntheticRegion::writeRegionFile(const std::filesystem::path &filePath, int regionX, int regionZ, const Options &options)
+{
+    // Two header sectors: locations, then timestamps
+    std::vector<char> out(2 * SECTOR_BYTES, 0);
+    uint64_t regionSeed = 0xC2B2AE3D27D4EB4FULL * static_cast<uint64_t>(regionX) + 0x165667B19E3779F9ULL * static_cast<uint64_t>(regionZ);
+    std::mt19937_64 presence(options.seed ^ (0xD6E8FEB86659FD93ULL + regionSeed));
+    for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+    {
+        int chunkX = regionX * N_CHUNKS_PER_REGION_XZ + chunkIdx % N_CHUNKS_PER_REGION_XZ;
+        int chunkZ = regionZ * N_CHUNKS_PER_REGION_XZ + chunkIdx / N_CHUNKS_PER_REGION_XZ;
+        if (drawUnit(presence) >= options.chunkFillRatio)
+        {
+            continue;
+        }
+        std::mt19937_64 random(options.seed + 0x9E3779B97F4A7C15ULL * (chunkIdx + 1) + regionSeed);
+        std::vector<char> payload = compressChunk(makeChunkNBT(chunkX, chunkZ, options, random), options.compression);
+
+        // Length covers the compression byte, chunks are padded to whole sectors
+        size_t offset = out.size();
+        writeBigEndian<uint32_t>(out, static_cast<uint32_t>(payload.size() + 1));
+        out.push_back(static_cast<char>(options.compression));
+        out.insert(out.end(), payload.begin(), payload.end());
+        out.resize((out.size() + SECTOR_BYTES - 1) / SECTOR_BYTES * SECTOR_BYTES, 0);
+
+        size_t nSectors = (out.size() - offset) / SECTOR_BYTES;
+        if (nSectors > 0xFF)
+        {
+            throw std::runtime_error("Synthetic chunk does not fit in 255 sectors");
+        }
+        uint32_t location = static_cast<uint32_t>(offset / SECTOR_BYTES) << OFFSET_SHIFT | static_cast<uint32_t>(nSectors);
+        for (int i = 0; i < 4; ++i)
+        {
+            out[chunkIdx * 4 + i] = static_cast<char>(location >> (24 - 8 * i));
+            out[SECTOR_BYTES + chunkIdx * 4 + i] = static_cast<char>(SYNTHETIC_TIMESTAMP >> (24 - 8 * i));
+        }
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), out.size());
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write " + filePath.string());
+    }
+}
@@ -0,0 +1,78 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <utility>
+
+ThreadPool::ThreadPool(size_t nThreads) : stopWorkers(false)
+{
+    if (nThreads == 0)
+    {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers.reserve(nThreads);
+    for (size_t i = 0; i < nThreads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerFunction, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Signal workers to stop once the queue is drained
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopWorkers = true;
+    }
+    tasksCondition.notify_all();
+
+    // Wait for workers to finish
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.push(std::move(task));
+    }
+    tasksCondition.notify_one();
+}
+
+size_t ThreadPool::getThreadCount() const
+{
+    return workers.size();
+}
+
+ThreadPool &ThreadPool::getShared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerFunction()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        // Wait for a task to be available
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            tasksCondition.wait(lock, [this]
+                                { return !tasks.empty() || stopWorkers; });
+            if (tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        // Run the task
+        task();
+    }
+}
@@ -0,0 +1,623 @@
+#include "world.h"
+#include "region_reader.h"
+#include "thread_pool.h"
+#include "region_file.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+const int REGION_SIZE_XZ = N_CHUNKS_PER_REGION_XZ * SECTION_SIZE;
+const size_t DEFAULT_MEMORY_BUDGET = size_t(1) << 30;
+const int64_t UNKNOWN_BLOCK_REPORT_SECONDS = 10; // Chunks decode lazily, their unknown names are reported together
+
+static std::atomic<uint64_t> nextWorldId(1);
+
+struct World::RegionSlot
+{
+    std::filesystem::path filePath;
+
+    // Guards the fields below, held while the region is opened so concurrent first accesses open it once
+    std::mutex mutex;
+    std::shared_ptr<const Region> region;
+    bool failed = false;
+    uint64_t lastAccess = 0;
+    std::shared_ptr<SectionDiskCache> sectionDiskCache; // Kept after eviction, which flushes it to disk
+    std::vector<uint64_t> chunkStamps; // Header entries the region was opened with, kept after eviction
+};
+
+// Location and timestamp of every chunk, a chunk changed if either did
+static std::vector<uint64_t> readChunkStamps(const std::filesystem::path &regionPath)
+{
+    RegionFile regionFile(regionPath, RegionFile::AccessPattern::Normal);
+    std::vector<uint64_t> chunkStamps(N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ);
+    for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+    {
+        chunkStamps[chunkIdx] = (static_cast<uint64_t>(regionFile.getChunkTimestamp(chunkIdx)) << 32) | regionFile.getChunkLocation(chunkIdx);
+    }
+    return chunkStamps;
+}
+
+World::World(const std::filesystem::path &regionDirectory, const std::unordered_map<std::string, uint16_t> &blockIdDict, uint16_t unknownBlockId)
+    : World(regionDirectory, std::make_shared<BlockIdResolver>(blockIdDict, unknownBlockId))
+{
+}
+
+World::World(const std::filesystem::path &regionDirectory, std::shared_ptr<BlockIdResolver> blockIdResolver)
+    : regionDirectory(regionDirectory),
+      blockIdResolver(std::move(blockIdResolver)), lastUnknownBlockReport(0),
+      minRegionX(0), maxRegionX(-1), minRegionZ(0), maxRegionZ(-1),
+      worldId(nextWorldId++), memoryBudget(DEFAULT_MEMORY_BUDGET), accessClock(0), regionGeneration(0),
+      cacheCompression(SectionDiskCache::Compression::None),
+      streamQueued(false), focusPending(false), focusX(0), focusZ(0), focusRadius(0)
+{
+    if (!std::filesystem::is_directory(regionDirectory))
+    {
+        throw std::runtime_error("Region directory not found: " + regionDirectory.string());
+    }
+
+    // Index the region files, anything not named r.X.Z.mca is ignored
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(regionDirectory))
+    {
+        int regionX;
+        int regionZ;
+        if (!entry.is_regular_file() || !RegionReader::parseRegionFileName(entry.path(), regionX, regionZ))
+        {
+            continue;
+        }
+
+        addRegionSlot(regionX, regionZ, entry.path());
+    }
+
+    std::cout << "World: " << regions.size() << " regions in " << regionDirectory.string() << std::endl;
+}
+
+World::~World()
+{
+    stopWatching();
+
+    // Wait for the streaming task, it uses the slots
+    std::unique_lock<std::mutex> lock(streamMutex);
+    focusPending = false;
+    streamCondition.wait(lock, [this]()
+                         { return !streamQueued; });
+    reportUnknownBlocks(true);
+}
+
+int64_t World::getRegionKey(int regionX, int regionZ)
+{
+    return (static_cast<int64_t>(regionX) << 32) | static_cast<uint32_t>(regionZ);
+}
+
+World::RegionSlot *World::addRegionSlot(int regionX, int regionZ, const std::filesystem::path &filePath)
+{
+    std::unique_lock<std::shared_mutex> lock(regionsMutex);
+    std::unique_ptr<RegionSlot> &slot = regions[getRegionKey(regionX, regionZ)];
+    if (!slot)
+    {
+        slot = std::make_unique<RegionSlot>();
+        slot->filePath = filePath;
+
+        // Lookups may have cached the missing region
+        regionGeneration++;
+    }
+
+    bool first = regions.size() == 1;
+    minRegionX = first ? regionX : std::min(minRegionX, regionX);
+    maxRegionX = first ? regionX : std::max(maxRegionX, regionX);
+    minRegionZ = first ? regionZ : std::min(minRegionZ, regionZ);
+    maxRegionZ = first ? regionZ : std::max(maxRegionZ, regionZ);
+    return slot.get();
+}
+
+World::RegionSlot *World::findRegionSlot(int regionX, int regionZ) const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    auto it = regions.find(getRegionKey(regionX, regionZ));
+    return it == regions.end() ? nullptr : it->second.get();
+}
+
+std::shared_ptr<const Region> World::getRegion(int regionX, int regionZ) const
+{
+    RegionSlot *slot = findRegionSlot(regionX, regionZ);
+    if (!slot)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    slot->lastAccess = ++accessClock;
+    if (!slot->region && !slot->failed)
+    {
+        try
+        {
+            // The cache outlives evictions, a second one for the same file would overwrite the first
+            if (!slot->sectionDiskCache && !cacheDirectory.empty())
+            {
+                std::filesystem::path cachePath = SectionDiskCache::getCachePath(cacheDirectory, slot->filePath);
+                slot->sectionDiskCache = std::make_shared<SectionDiskCache>(cachePath, slot->filePath, blockIdResolver->getDictionaryHash(), cacheCompression);
+            }
+            slot->chunkStamps = readChunkStamps(slot->filePath);
+            slot->region = std::make_shared<const Region>(RegionReader::getLazyRegion(slot->filePath, blockIdResolver, slot->sectionDiskCache));
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error loading region " << slot->filePath.string() << ": " << e.what() << std::endl;
+            slot->failed = true;
+        }
+    }
+
+    return slot->region;
+}
+
+const Region *World::findRegion(int regionX, int regionZ) const
+{
+    // Each thread remembers the last region it used, so block lookups skip the slot lock and
+    // the reference count. The pointer does not own the region, its slot does: evictions and
+    // reloads bump the generation, which makes every thread look its region up again instead of
+    // keeping an evicted one alive.
+    struct RegionLookup
+    {
+        uint64_t worldId = 0;
+        int64_t key = 0;
+        uint64_t regionGeneration = 0;
+        const Region *region = nullptr;
+    };
+    thread_local RegionLookup lookup;
+
+    int64_t key = getRegionKey(regionX, regionZ);
+    uint64_t generation = regionGeneration.load(std::memory_order_acquire);
+    if (lookup.worldId != worldId || lookup.key != key || lookup.regionGeneration != generation)
+    {
+        lookup.region = getRegion(regionX, regionZ).get();
+        lookup.worldId = worldId;
+        lookup.key = key;
+        lookup.regionGeneration = generation;
+    }
+
+    return lookup.region;
+}
+
+std::vector<std::pair<int, int>> World::getRegionCoordinates() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    std::vector<std::pair<int, int>> coordinates;
+    coordinates.reserve(regions.size());
+    for (const auto &[key, slot] : regions)
+    {
+        coordinates.emplace_back(static_cast<int>(key >> 32), static_cast<int>(static_cast<uint32_t>(key)));
+    }
+    std::sort(coordinates.begin(), coordinates.end());
+    return coordinates;
+}
+
+size_t World::getRegionCount() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    return regions.size();
+}
+
+size_t World::getLoadedRegionCount() const
+{
+    std::shared_lock<std::shared_mutex> regionsLock(regionsMutex);
+    size_t nLoadedRegions = 0;
+    for (const auto &[key, slot] : regions)
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        nLoadedRegions += slot->region != nullptr;
+    }
+    return nLoadedRegions;
+}
+
+void World::setMemoryBudget(size_t bytes)
+{
+    memoryBudget = bytes;
+}
+
+void World::setCacheDirectory(const std::filesystem::path &cacheDirectory, SectionDiskCache::Compression compression)
+{
+    this->cacheDirectory = cacheDirectory;
+    cacheCompression = compression;
+}
+
+/*****
+ ****
+ *** Streaming
+ ****
+ ******/
+
+void World::updateFocus(int x, int z, int radius)
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    focusX = x;
+    focusZ = z;
+    focusRadius = radius;
+    focusPending = true;
+
+    // A queued task picks up the new focus
+    if (!streamQueued)
+    {
+        streamQueued = true;
+        ThreadPool::getShared().submit([this]()
+                                       { streamRegions(); });
+    }
+}
+
+void World::streamRegions()
+{
+    while (true)
+    {
+        int x;
+        int z;
+        int radius;
+        {
+            std::lock_guard<std::mutex> lock(streamMutex);
+            if (!focusPending)
+            {
+                // Notify under the lock, the destructor may be waiting
+                streamQueued = false;
+                streamCondition.notify_all();
+                return;
+            }
+            focusPending = false;
+            x = focusX;
+            z = focusZ;
+            radius = focusRadius;
+        }
+
+        // Open the regions around the focus, which also makes them the most recently used
+        uint64_t focusTime = accessClock + 1;
+        for (int regionX = getRegionOfBlock(x - radius); regionX <= getRegionOfBlock(x + radius); ++regionX)
+        {
+            for (int regionZ = getRegionOfBlock(z - radius); regionZ <= getRegionOfBlock(z + radius); ++regionZ)
+            {
+                getRegion(regionX, regionZ);
+            }
+        }
+
+        evictRegions(focusTime);
+        reportUnknownBlocks(false);
+    }
+}
+
+void World::evictRegions(uint64_t focusTime)
+{
+    struct LoadedRegion
+    {
+        RegionSlot *slot;
+        uint64_t lastAccess;
+        size_t memoryUsage;
+    };
+
+    // Measure the loaded regions
+    std::vector<LoadedRegion> loadedRegions;
+    size_t memoryUsage = 0;
+    std::shared_lock<std::shared_mutex> regionsLock(regionsMutex);
+    for (const auto &[key, slot] : regions)
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        if (slot->region)
+        {
+            loadedRegions.push_back({slot.get(), slot->lastAccess, slot->region->getMemoryUsage()});
+            memoryUsage += loadedRegions.back().memoryUsage;
+        }
+    }
+
+    // Evict least recently used first, regions around the current focus are kept
+    std::sort(loadedRegions.begin(), loadedRegions.end(), [](const LoadedRegion &a, const LoadedRegion &b)
+              { return a.lastAccess < b.lastAccess; });
+    size_t nEvicted = 0;
+    std::vector<std::shared_ptr<SectionDiskCache>> evictedCaches;
+    for (const LoadedRegion &loadedRegion : loadedRegions)
+    {
+        if (memoryUsage <= memoryBudget || loadedRegion.lastAccess >= focusTime)
+        {
+            break;
+        }
+
+        // Skip regions used since they were measured
+        std::lock_guard<std::mutex> lock(loadedRegion.slot->mutex);
+        if (loadedRegion.slot->lastAccess != loadedRegion.lastAccess)
+        {
+            continue;
+        }
+        loadedRegion.slot->region.reset();
+        if (loadedRegion.slot->sectionDiskCache)
+        {
+            evictedCaches.push_back(loadedRegion.slot->sectionDiskCache);
+        }
+        memoryUsage -= loadedRegion.memoryUsage;
+        nEvicted++;
+    }
+    regionsLock.unlock();
+
+    // The chunks the evicted regions stored in their caches go to disk, outside the locks
+    for (const std::shared_ptr<SectionDiskCache> &sectionDiskCache : evictedCaches)
+    {
+        try
+        {
+            sectionDiskCache->flush();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Failed to write section cache: " << e.what() << std::endl;
+        }
+    }
+
+    if (nEvicted > 0)
+    {
+        regionGeneration++;
+        std::cout << "Region cache: evicted " << nEvicted << " regions, " << loadedRegions.size() - nEvicted
+                  << " loaded, " << memoryUsage / (1024.0 * 1024.0) << " MB" << std::endl;
+    }
+}
+
+void World::reportUnknownBlocks(bool force) const
+{
+    // At most one report per interval, whichever thread gets there first prints it
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t lastReport = lastUnknownBlockReport.load(std::memory_order_relaxed);
+    if (!force && (now - lastReport < UNKNOWN_BLOCK_REPORT_SECONDS || !lastUnknownBlockReport.compare_exchange_strong(lastReport, now)))
+    {
+        return;
+    }
+    blockIdResolver->reportUnknownBlocks(std::cerr);
+}
+
+BlockId World::getBlockAt(int x, int y, int z) const
+{
+    if (y < 0 || y >= CHUNK_SIZE_Y)
+    {
+        return 0xFFFF;
+    }
+
+    const Region *region = findRegion(getRegionOfBlock(x), getRegionOfBlock(z));
+    if (!region)
+    {
+        return 0xFFFF;
+    }
+
+    return region->getBlockAt(x & (REGION_SIZE_XZ - 1), y, z & (REGION_SIZE_XZ - 1));
+}
+
+const SectionData &World::getSectionAt(int sx, int sy, int sz) const
+{
+    if (sy < 0 || sy >= N_SECTIONS_PER_CHUNK_Y)
+    {
+        return SectionData::getMissing();
+    }
+
+    const Region *region = findRegion(getRegionOfSection(sx), getRegionOfSection(sz));
+    if (!region)
+    {
+        return SectionData::getMissing();
+    }
+
+    return region->getSectionAt(sx & REGION_MASK, sy, sz & REGION_MASK);
+}
+
+bool World::isSectionMissing(int sx, int sy, int sz) const
+{
+    if (sy < 0 || sy >= N_SECTIONS_PER_CHUNK_Y)
+    {
+        return true;
+    }
+
+    const Region *region = findRegion(getRegionOfSection(sx), getRegionOfSection(sz));
+    return !region || region->isSectionMissing(sx & REGION_MASK, sy, sz & REGION_MASK);
+}
+
+void World::loadChunk(int chunkX, int chunkZ) const
+{
+    std::shared_ptr<const Region> region = getRegion(getRegionOfSection(chunkX), getRegionOfSection(chunkZ));
+    if (region)
+    {
+        region->loadChunk(chunkX & REGION_MASK, chunkZ & REGION_MASK);
+    }
+}
+
+bool World::isSectionUniform(int sx, int sy, int sz) const
+{
+    return getSectionAt(sx, sy, sz).isUniform();
+}
+
+BlockId World::getUniformBlockId(int sx, int sy, int sz) const
+{
+    return getSectionAt(sx, sy, sz).getPalette()[0];
+}
+
+int World::getMinX() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    return minRegionX * REGION_SIZE_XZ;
+}
+
+int World::getMaxX() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    return (maxRegionX + 1) * REGION_SIZE_XZ;
+}
+
+int World::getMinZ() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    return minRegionZ * REGION_SIZE_XZ;
+}
+
+int World::getMaxZ() const
+{
+    std::shared_lock<std::shared_mutex> lock(regionsMutex);
+    return (maxRegionZ + 1) * REGION_SIZE_XZ;
+}
+
+int World::getSizeY() const
+{
+    return CHUNK_SIZE_Y;
+}
+
+/*****
+ ****
+ *** Live reload
+ ****
+ ******/
+
+std::vector<std::tuple<int, int, int>> World::refreshRegion(const std::filesystem::path &regionPath)
+{
+    std::vector<std::tuple<int, int, int>> changedSections;
+    int regionX;
+    int regionZ;
+    if (!RegionReader::parseRegionFileName(regionPath, regionX, regionZ))
+    {
+        return changedSections;
+    }
+
+    // The header may be mid-write, the next change reads it again
+    std::vector<uint64_t> chunkStamps;
+    try
+    {
+        chunkStamps = readChunkStamps(regionPath);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error reading region " << regionPath.string() << ": " << e.what() << std::endl;
+        return changedSections;
+    }
+
+    auto addChunkSections = [&](int chunkIdx)
+    {
+        int chunkX = regionX * N_CHUNKS_PER_REGION_XZ + chunkIdx % N_CHUNKS_PER_REGION_XZ;
+        int chunkZ = regionZ * N_CHUNKS_PER_REGION_XZ + chunkIdx / N_CHUNKS_PER_REGION_XZ;
+        for (int sy = 0; sy < N_SECTIONS_PER_CHUNK_Y; ++sy)
+        {
+            changedSections.emplace_back(chunkX, sy, chunkZ);
+        }
+    };
+
+    // A new region replaces missing blocks wherever it has chunks
+    RegionSlot *slot = findRegionSlot(regionX, regionZ);
+    if (!slot)
+    {
+        addRegionSlot(regionX, regionZ, regionPath);
+        for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+        {
+            if (static_cast<uint32_t>(chunkStamps[chunkIdx]) != 0)
+            {
+                addChunkSections(chunkIdx);
+            }
+        }
+        return changedSections;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+
+    // A region that failed to open is tried again, like a new one
+    if (slot->failed)
+    {
+        slot->failed = false;
+        slot->chunkStamps.clear();
+        regionGeneration++;
+        for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+        {
+            if (static_cast<uint32_t>(chunkStamps[chunkIdx]) != 0)
+            {
+                addChunkSections(chunkIdx);
+            }
+        }
+        return changedSections;
+    }
+
+    // Nothing was read from a region that was never opened
+    if (slot->chunkStamps.empty())
+    {
+        return changedSections;
+    }
+
+    std::vector<int> changedChunks;
+    for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+    {
+        if (chunkStamps[chunkIdx] != slot->chunkStamps[chunkIdx])
+        {
+            changedChunks.push_back(chunkIdx);
+        }
+    }
+    slot->chunkStamps = std::move(chunkStamps);
+    if (changedChunks.empty())
+    {
+        return changedSections;
+    }
+
+    // Sections of an evicted region may still be on screen, all of a changed chunk is reported
+    if (!slot->region)
+    {
+        for (int chunkIdx : changedChunks)
+        {
+            addChunkSections(chunkIdx);
+        }
+        return changedSections;
+    }
+
+    // Reopen the region, unchanged chunks carry over and changed ones that were decoded are decoded again.
+    // The section cache stays, its entries are keyed by the header entries too.
+    std::shared_ptr<const Region> previousRegion = slot->region;
+    std::shared_ptr<Region> region;
+    try
+    {
+        region = std::make_shared<Region>(RegionReader::getLazyRegion(slot->filePath, blockIdResolver, slot->sectionDiskCache));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error reloading region " << slot->filePath.string() << ": " << e.what() << std::endl;
+        return changedSections;
+    }
+
+    std::vector<bool> isChunkChanged(N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ, false);
+    for (int chunkIdx : changedChunks)
+    {
+        isChunkChanged[chunkIdx] = true;
+    }
+    for (int chunkIdx = 0; chunkIdx < N_CHUNKS_PER_REGION_XZ * N_CHUNKS_PER_REGION_XZ; ++chunkIdx)
+    {
+        int chunkX = chunkIdx % N_CHUNKS_PER_REGION_XZ;
+        int chunkZ = chunkIdx / N_CHUNKS_PER_REGION_XZ;
+        if (!isChunkChanged[chunkIdx])
+        {
+            region->adoptChunk(*previousRegion, chunkX, chunkZ);
+            continue;
+        }
+        if (!previousRegion->isChunkLoaded(chunkX, chunkZ))
+        {
+            continue;
+        }
+
+        // Only sections whose blocks differ need meshing again
+        region->loadChunk(chunkX, chunkZ);
+        for (int sy = 0; sy < N_SECTIONS_PER_CHUNK_Y; ++sy)
+        {
+            if (region->getSectionAt(chunkX, sy, chunkZ) != previousRegion->getSectionAt(chunkX, sy, chunkZ))
+            {
+                changedSections.emplace_back(regionX * N_CHUNKS_PER_REGION_XZ + chunkX, sy, regionZ * N_CHUNKS_PER_REGION_XZ + chunkZ);
+            }
+        }
+    }
+
+    slot->region = std::move(region);
+    regionGeneration++;
+    return changedSections;
+}
+
+void World::startWatching(SectionsChangedCallback onSectionsChanged)
+{
+    stopWatching();
+    regionWatcher = std::make_unique<RegionWatcher>(regionDirectory, [this, onSectionsChanged](const std::filesystem::path &regionPath)
+                                                    {
+        std::vector<std::tuple<int, int, int>> changedSections = refreshRegion(regionPath);
+        if (!changedSections.empty())
+        {
+            onSectionsChanged(changedSections);
+        } });
+}
+
+void World::stopWatching()
+{
+    regionWatcher.reset();
+}
@@ -0,0 +1,303 @@
+// Decodes region files without a window and reports the throughput of every decode stage, as
+// text or JSON, with the allocations made per chunk, so the loader can be measured and
+// regression tested on headless machines.
+//
+// Usage: blocksage-decode [--json] [--repeat N] [--block-dictionary block_id_dictionary.json] <region files or directories>...
+//
+// Stage times are summed over the decode workers, so their MB/s and chunks/s are per worker.
+// The totals of a file are against wall time. MB are 10^6 bytes.
+
+#include "region_reader.h"
+#include "chunk_decode_context.h"
+#include "block_table.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+const char *STAGE_NAMES[N_DECODE_STAGES] = {"read", "inflate", "parse", "palette", "unpack", "store"};
+
+struct DecodeResult
+{
+    std::string path;
+    uint64_t fileBytes = 0;
+    uint64_t chunks = 0;
+    uint64_t sections = 0;
+    double seconds = 0.0;
+    ChunkDecodeStats stats;
+};
+
+double getRate(double amount, double seconds)
+{
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+std::unique_ptr<BlockIdResolver> loadBlockIdResolver(const fs::path &blockDictionaryPath)
+{
+    if (blockDictionaryPath.empty())
+    {
+        return std::make_unique<BlockIdResolver>(BlockTable());
+    }
+
+    std::ifstream file(blockDictionaryPath);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open block id dictionary file: " + blockDictionaryPath.string());
+    }
+    std::unordered_map<std::string, uint16_t> blockIdDict;
+    json blockIdDictJson = json::parse(file);
+    for (auto it = blockIdDictJson.begin(); it != blockIdDictJson.end(); ++it)
+    {
+        blockIdDict[it.key()] = static_cast<uint16_t>(it.value());
+    }
+    if (blockIdDict.empty())
+    {
+        std::cerr << "Empty block dictionary, every block decodes to the unknown ID" << std::endl;
+    }
+    return std::make_unique<BlockIdResolver>(blockIdDict);
+}
+
+std::vector<fs::path> findRegionFiles(const std::vector<fs::path> &inputs)
+{
+    std::vector<fs::path> regionFiles;
+    for (const fs::path &input : inputs)
+    {
+        if (!fs::is_directory(input))
+        {
+            regionFiles.push_back(input);
+            continue;
+        }
+
+        // Directories are decoded in name order, so runs are comparable
+        std::vector<fs::path> directoryFiles;
+        for (const fs::directory_entry &entry : fs::directory_iterator(input))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".mca")
+            {
+                directoryFiles.push_back(entry.path());
+            }
+        }
+        std::sort(directoryFiles.begin(), directoryFiles.end());
+        regionFiles.insert(regionFiles.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+    return regionFiles;
+}
+
+DecodeResult decodeRegionFile(const fs::path &regionPath, BlockIdResolver &blockIdResolver)
+{
+    DecodeResult result;
+    result.path = regionPath.string();
+    result.fileBytes = fs::file_size(regionPath);
+
+    ChunkDecodeStats statsBefore = ChunkDecodeContext::getTotalStats();
+    auto start = std::chrono::steady_clock::now();
+    Region region = RegionReader::getRegion(regionPath, blockIdResolver);
+    auto end = std::chrono::steady_clock::now();
+    ChunkDecodeStats statsAfter = ChunkDecodeContext::getTotalStats();
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.chunks = statsAfter.chunks - statsBefore.chunks;
+    result.stats.decompressorSetups = statsAfter.decompressorSetups - statsBefore.decompressorSetups;
+    result.stats.bufferGrowths = statsAfter.bufferGrowths - statsBefore.bufferGrowths;
+    result.stats.arenaBlockAllocations = statsAfter.arenaBlockAllocations - statsBefore.arenaBlockAllocations;
+    for (size_t stageIdx = 0; stageIdx < N_DECODE_STAGES; ++stageIdx)
+    {
+        result.stats.stageNanoseconds[stageIdx] = statsAfter.stageNanoseconds[stageIdx] - statsBefore.stageNanoseconds[stageIdx];
+        result.stats.stageBytes[stageIdx] = statsAfter.stageBytes[stageIdx] - statsBefore.stageBytes[stageIdx];
+    }
+
+    // Sections that decoded to something, as a check that the run did real work
+    for (int chunkX = 0; chunkX < N_CHUNKS_PER_REGION_XZ; ++chunkX)
+    {
+        for (int chunkZ = 0; chunkZ < N_CHUNKS_PER_REGION_XZ; ++chunkZ)
+        {
+            for (int sy = 0; sy < N_SECTIONS_PER_CHUNK_Y; ++sy)
+            {
+                result.sections += region.isSectionMissing(chunkX, sy, chunkZ) ? 0 : 1;
+            }
+        }
+    }
+
+    return result;
+}
+
+void addResult(DecodeResult &total, const DecodeResult &result)
+{
+    total.fileBytes += result.fileBytes;
+    total.chunks += result.chunks;
+    total.sections += result.sections;
+    total.seconds += result.seconds;
+    total.stats.decompressorSetups += result.stats.decompressorSetups;
+    total.stats.bufferGrowths += result.stats.bufferGrowths;
+    total.stats.arenaBlockAllocations += result.stats.arenaBlockAllocations;
+    for (size_t stageIdx = 0; stageIdx < N_DECODE_STAGES; ++stageIdx)
+    {
+        total.stats.stageNanoseconds[stageIdx] += result.stats.stageNanoseconds[stageIdx];
+        total.stats.stageBytes[stageIdx] += result.stats.stageBytes[stageIdx];
+    }
+}
+
+// Decompressor setups, output buffer growths and NBT arena blocks, none once the workers are warm
+uint64_t getAllocationCount(const ChunkDecodeStats &stats)
+{
+    return stats.decompressorSetups + stats.bufferGrowths + stats.arenaBlockAllocations;
+}
+
+json toJson(const DecodeResult &result)
+{
+    json stages = json::object();
+    for (size_t stageIdx = 0; stageIdx < N_DECODE_STAGES; ++stageIdx)
+    {
+        double seconds = result.stats.stageNanoseconds[stageIdx] / 1e9;
+        stages[STAGE_NAMES[stageIdx]] = {
+            {"seconds", seconds},
+            {"bytes", result.stats.stageBytes[stageIdx]},
+            {"mbPerSecond", getRate(result.stats.stageBytes[stageIdx] / 1e6, seconds)},
+            {"chunksPerSecond", getRate(static_cast<double>(result.chunks), seconds)}};
+    }
+
+    return {
+        {"path", result.path},
+        {"fileBytes", result.fileBytes},
+        {"chunks", result.chunks},
+        {"sections", result.sections},
+        {"seconds", result.seconds},
+        {"mbPerSecond", getRate(result.fileBytes / 1e6, result.seconds)},
+        {"chunksPerSecond", getRate(static_cast<double>(result.chunks), result.seconds)},
+        {"stages", stages},
+        {"allocations", {
+            {"decompressorSetups", result.stats.decompressorSetups},
+            {"bufferGrowths", result.stats.bufferGrowths},
+            {"arenaBlockAllocations", result.stats.arenaBlockAllocations},
+            {"perChunk", getRate(static_cast<double>(getAllocationCount(result.stats)), static_cast<double>(result.chunks))}}}};
+}
+
+void printText(std::ostream &out, const DecodeResult &result)
+{
+    out << std::fixed << std::setprecision(1);
+    out << result.path << ": " << result.chunks << " chunks, " << result.sections << " sections, "
+        << result.fileBytes / 1e6 << " MB in " << result.seconds * 1e3 << " ms, "
+        << getRate(result.fileBytes / 1e6, result.seconds) << " MB/s, "
+        << getRate(static_cast<double>(result.chunks), result.seconds) << " chunks/s" << std::endl;
+
+    out << "  " << std::left << std::setw(10) << "stage" << std::right
+        << std::setw(12) << "time ms" << std::setw(12) << "MB/s" << std::setw(14) << "chunks/s" << std::endl;
+    for (size_t stageIdx = 0; stageIdx < N_DECODE_STAGES; ++stageIdx)
+    {
+        double seconds = result.stats.stageNanoseconds[stageIdx] / 1e9;
+        out << "  " << std::left << std::setw(10) << STAGE_NAMES[stageIdx] << std::right
+            << std::setw(12) << seconds * 1e3
+            << std::setw(12) << getRate(result.stats.stageBytes[stageIdx] / 1e6, seconds)
+            << std::setw(14) << getRate(static_cast<double>(result.chunks), seconds) << std::endl;
+    }
+
+    out << "  allocations: " << result.stats.decompressorSetups << " decompressor setups, "
+        << result.stats.bufferGrowths << " buffer growths, " << result.stats.arenaBlockAllocations << " arena blocks, "
+        << std::setprecision(3) << getRate(static_cast<double>(getAllocationCount(result.stats)), static_cast<double>(result.chunks))
+        << " per chunk" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    bool jsonOutput = false;
+    int nRepeats = 1;
+    fs::path blockDictionaryPath;
+    std::vector<fs::path> inputs;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--json")
+        {
+            jsonOutput = true;
+        }
+        else if (argument == "--repeat" && i + 1 < argc)
+        {
+            nRepeats = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (argument == "--block-dictionary" && i + 1 < argc)
+        {
+            blockDictionaryPath = argv[++i];
+        }
+        else
+        {
+            inputs.push_back(argument);
+        }
+    }
+    if (inputs.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--json] [--repeat N] [--block-dictionary block_id_dictionary.json] <region files or directories>..." << std::endl;
+        return 1;
+    }
+
+    // The reader logs its progress to stdout, keep stdout for the report
+    std::ostream report(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    int exitCode = 0;
+    try
+    {
+        if (blockDictionaryPath.empty() && BlockTable::getBlockCount() == 0)
+        {
+            std::cerr << "No block dictionary, every block decodes to the unknown ID" << std::endl;
+        }
+        std::unique_ptr<BlockIdResolver> blockIdResolver = loadBlockIdResolver(blockDictionaryPath);
+
+        ChunkDecodeContext::setStageTiming(true);
+        DecodeResult total;
+        total.path = "total";
+        json fileResults = json::array();
+        for (const fs::path &regionPath : findRegionFiles(inputs))
+        {
+            for (int repeat = 0; repeat < nRepeats; ++repeat)
+            {
+                DecodeResult result;
+                try
+                {
+                    result = decodeRegionFile(regionPath, *blockIdResolver);
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << "Error decoding " << regionPath.string() << ": " << e.what() << std::endl;
+                    exitCode = 1;
+                    break;
+                }
+
+                addResult(total, result);
+                if (jsonOutput)
+                {
+                    fileResults.push_back(toJson(result));
+                }
+                else
+                {
+                    printText(report, result);
+                }
+            }
+        }
+
+        if (jsonOutput)
+        {
+            report << json{{"files", fileResults}, {"total", toJson(total)}}.dump(2) << std::endl;
+        }
+        else
+        {
+            printText(report, total);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        exitCode = 1;
+    }
+
+    std::cout.rdbuf(report.rdbuf());
+    return exitCode;
+}
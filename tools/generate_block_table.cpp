@@ -0,0 +1,178 @@
+// Generates the block table compiled into the viewer from the block ID and color dictionaries,
+// so startup needs no JSON parsing. Run it again whenever the dictionaries change.
+//
+// The CMake build runs it when BLOCKSAGE_DATA_DIR holds the dictionaries.
+// Usage: generate_block_table data/block_id_dictionary.json data/block_color_dictionary.json include/generated/block_table_data.h
+
+#include "perfect_hash.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+// Blocks the viewer skips when meshing
+const std::vector<std::string> NO_RENDER_BLOCK_NAMES = {"air"};
+
+struct BlockEntry
+{
+    std::string name;
+    uint16_t id;
+    float color[3];
+    bool hasColor;
+};
+
+json readJson(const fs::path &filePath)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + filePath.string());
+    }
+    return json::parse(file);
+}
+
+std::string formatFloat(float value)
+{
+    std::ostringstream out;
+    out << std::setprecision(9) << value;
+    std::string text = out.str();
+    if (text.find_first_of(".e") == std::string::npos)
+    {
+        text += ".0";
+    }
+    return text + "f";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <block_id_dictionary.json> <block_color_dictionary.json> <output header>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        // Sorted by name, so the output only changes with the dictionaries
+        std::map<std::string, BlockEntry> blocks;
+        json blockIdDict = readJson(argv[1]);
+        for (auto it = blockIdDict.begin(); it != blockIdDict.end(); ++it)
+        {
+            blocks[it.key()] = {it.key(), static_cast<uint16_t>(it.value()), {0.0f, 0.0f, 0.0f}, false};
+        }
+
+        json blockColorDict = readJson(argv[2]);
+        for (auto it = blockColorDict.begin(); it != blockColorDict.end(); ++it)
+        {
+            auto block = blocks.find(it.key());
+            if (block == blocks.end())
+            {
+                std::cerr << "Skipping color of unknown block " << it.key() << std::endl;
+                continue;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                block->second.color[i] = it.value()[i].get<float>();
+            }
+            block->second.hasColor = true;
+        }
+
+        std::vector<BlockEntry> entries;
+        std::vector<std::string_view> names;
+        entries.reserve(blocks.size());
+        for (auto &[name, block] : blocks)
+        {
+            entries.push_back(block);
+        }
+        for (const BlockEntry &entry : entries)
+        {
+            names.push_back(entry.name);
+        }
+        PerfectHash::Table table = PerfectHash::build(names);
+
+        std::ostringstream out;
+        out << "// Generated by tools/generate_block_table.cpp from " << fs::path(argv[1]).filename().string()
+            << " and " << fs::path(argv[2]).filename().string() << ", do not edit.\n";
+        out << "#pragma once\n\n";
+        out << "inline constexpr size_t BLOCK_TABLE_COUNT = " << entries.size() << ";\n\n";
+
+        out << "inline constexpr BlockInfo BLOCK_TABLE_BLOCKS[] = {\n";
+        for (const BlockEntry &entry : entries)
+        {
+            bool noRender = std::find(NO_RENDER_BLOCK_NAMES.begin(), NO_RENDER_BLOCK_NAMES.end(), entry.name) != NO_RENDER_BLOCK_NAMES.end();
+            std::string flags;
+            if (entry.hasColor)
+            {
+                flags = "BLOCK_HAS_COLOR";
+            }
+            if (noRender)
+            {
+                flags += flags.empty() ? "BLOCK_NO_RENDER" : " | BLOCK_NO_RENDER";
+            }
+            if (flags.empty())
+            {
+                flags = "0";
+            }
+            out << "    {" << json(entry.name).dump() << ", " << entry.id << ", {"
+                << formatFloat(entry.color[0]) << ", " << formatFloat(entry.color[1]) << ", " << formatFloat(entry.color[2]) << "}, "
+                << flags << "},\n";
+        }
+        if (entries.empty())
+        {
+            out << "    {\"\", 0xFFFF, {0.0f, 0.0f, 0.0f}, 0},\n";
+        }
+        out << "};\n\n";
+
+        out << "inline constexpr uint32_t BLOCK_TABLE_SEEDS[] = {";
+        for (size_t i = 0; i < table.seeds.size(); ++i)
+        {
+            out << (i % 16 == 0 ? "\n    " : " ") << table.seeds[i] << ",";
+        }
+        out << "\n};\n\n";
+
+        out << "inline constexpr int32_t BLOCK_TABLE_SLOTS[] = {";
+        for (size_t i = 0; i < table.slots.size(); ++i)
+        {
+            out << (i % 16 == 0 ? "\n    " : " ") << table.slots[i] << ",";
+        }
+        out << "\n};\n";
+
+        // Leave the header untouched when nothing changed, it would rebuild everything
+        fs::path outputPath = argv[3];
+        std::string content = out.str();
+        std::ifstream existing(outputPath, std::ios::binary);
+        if (existing.is_open() && std::string(std::istreambuf_iterator<char>(existing), {}) == content)
+        {
+            return 0;
+        }
+        existing.close();
+
+        if (outputPath.has_parent_path())
+        {
+            fs::create_directories(outputPath.parent_path());
+        }
+        std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+        output << content;
+        if (!output)
+        {
+            throw std::runtime_error("Failed to write " + outputPath.string());
+        }
+        std::cout << "Wrote " << entries.size() << " blocks in " << table.slots.size() << " slots to " << outputPath.string() << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+// Writes deterministic region files for load and meshing stress tests, along with the block
+// dictionaries the viewer and blocksage-decode need to read them. The same options give the
+// same bytes on every machine.
+//
+// Usage: blocksage-generate [--seed N] [--regions N] [--fill ratio] [--uniform-share share]
+//                           [--palette-sizes 2,5,16] [--palette-weights 1,1,1]
+//                           [--pattern random|checkerboard] [--compression zlib|gzip|none|lz4] <output dir>
+//
+// Regions r.0.0 to r.(N-1).(N-1) are written. Palette sizes set the bit widths of the sections
+// that are not uniform, checkerboards give the highest face count a section can have.
+
+#include "synthetic_region.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+template <typename T>
+std::vector<T> parseList(const std::string &text)
+{
+    std::vector<T> values;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        values.push_back(static_cast<T>(std::stod(item)));
+    }
+    return values;
+}
+
+ChunkCompression parseCompression(const std::string &name)
+{
+    if (name == "gzip")
+    {
+        return ChunkCompression::Gzip;
+    }
+    if (name == "zlib")
+    {
+        return ChunkCompression::Zlib;
+    }
+    if (name == "none")
+    {
+        return ChunkCompression::Uncompressed;
+    }
+    if (name == "lz4")
+    {
+        return ChunkCompression::LZ4;
+    }
+    throw std::invalid_argument("Unknown compression: " + name);
+}
+
+SyntheticRegion::Pattern parsePattern(const std::string &name)
+{
+    if (name == "random")
+    {
+        return SyntheticRegion::Pattern::Random;
+    }
+    if (name == "checkerboard")
+    {
+        return SyntheticRegion::Pattern::Checkerboard;
+    }
+    throw std::invalid_argument("Unknown pattern: " + name);
+}
+
+void writeJson(const fs::path &filePath, const json &value)
+{
+    std::ofstream file(filePath, std::ios::trunc);
+    file << value.dump() << std::endl;
+    if (!file)
+    {
+        throw std::runtime_error("Failed to write " + filePath.string());
+    }
+}
+
+void writeBlockDictionaries(const fs::path &outputDirectory)
+{
+    // Colors spread over the blocks so neighbours stay distinguishable, air has none. Components
+    // are 0..255, as in the dictionaries under data/
+    json blockIdDict = json::object();
+    json blockColorDict = json::object();
+    for (int blockIdx = 0; blockIdx < N_SYNTHETIC_BLOCKS; ++blockIdx)
+    {
+        std::string name = SyntheticRegion::getBlockName(blockIdx);
+        blockIdDict[name] = blockIdx;
+        if (blockIdx != 0)
+        {
+            blockColorDict[name] = {blockIdx * 37 % 256, blockIdx * 91 % 256, blockIdx * 173 % 256};
+        }
+    }
+    writeJson(outputDirectory / "block_id_dictionary.json", blockIdDict);
+    writeJson(outputDirectory / "block_color_dictionary.json", blockColorDict);
+}
+
+int main(int argc, char *argv[])
+{
+    SyntheticRegion::Options options;
+    int nRegionsXZ = 1;
+    fs::path outputDirectory;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (argument == "--seed" && hasValue)
+            {
+                options.seed = std::stoull(argv[++i]);
+            }
+            else if (argument == "--regions" && hasValue)
+            {
+                nRegionsXZ = std::stoi(argv[++i]);
+            }
+            else if (argument == "--fill" && hasValue)
+            {
+                options.chunkFillRatio = std::stod(argv[++i]);
+            }
+            else if (argument == "--uniform-share" && hasValue)
+            {
+                options.uniformSectionShare = std::stod(argv[++i]);
+            }
+            else if (argument == "--palette-sizes" && hasValue)
+            {
+                options.paletteSizes = parseList<int>(argv[++i]);
+            }
+            else if (argument == "--palette-weights" && hasValue)
+            {
+                options.paletteSizeWeights = parseList<double>(argv[++i]);
+            }
+            else if (argument == "--pattern" && hasValue)
+            {
+                options.pattern = parsePattern(argv[++i]);
+            }
+            else if (argument == "--compression" && hasValue)
+            {
+                options.compression = parseCompression(argv[++i]);
+            }
+            else if (argument[0] != '-' && outputDirectory.empty())
+            {
+                outputDirectory = argument;
+            }
+            else
+            {
+                throw std::invalid_argument("Unexpected argument: " + argument);
+            }
+        }
+        if (outputDirectory.empty() || nRegionsXZ < 1)
+        {
+            throw std::invalid_argument("Expected an output directory and at least one region");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--seed N] [--regions N] [--fill ratio] [--uniform-share share] [--palette-sizes 2,5,16] "
+                  << "[--palette-weights 1,1,1] [--pattern random|checkerboard] [--compression zlib|gzip|none|lz4] <output dir>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        fs::create_directories(outputDirectory);
+        writeBlockDictionaries(outputDirectory);
+        for (int regionX = 0; regionX < nRegionsXZ; ++regionX)
+        {
+            for (int regionZ = 0; regionZ < nRegionsXZ; ++regionZ)
+            {
+                fs::path regionPath = outputDirectory / ("r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".mca");
+                SyntheticRegion::writeRegionFile(regionPath, regionX, regionZ, options);
+                std::cout << "Wrote " << regionPath.string() << " (" << fs::file_size(regionPath) / 1024 << " KiB)" << std::endl;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}